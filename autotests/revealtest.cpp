@@ -0,0 +1,253 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+/* Sends REVEAL with several paths to a kmozillahelper on a private session bus,
+ * once with a fake org.freedesktop.FileManager1 that has to get all of them in
+ * one ShowItems call, and once without, when the helper opens the directories
+ * with the preferred application for inode/directory itself. */
+
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QProcess>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTemporaryDir>
+#include <QtDBus/QDBusConnection>
+#include <QtTest/QtTest>
+
+// in ms, for anything the helper does
+static const int TIMEOUT = 10000;
+
+class FakeFileManager : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.FileManager1")
+public:
+    QList<QStringList> calls;
+public slots:
+    void ShowItems(const QStringList& uris, const QString& startupId)
+    {
+        Q_UNUSED(startupId);
+        calls << uris;
+    }
+};
+
+class RevealTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void showItems();
+    void withoutFileManager1();
+private:
+    void writeFile(const QString& path, const QByteArray& data);
+    bool startHelper(QProcess &helper);
+    bool readLine(QProcess &helper, QByteArray &line);
+    // Returns the status of the reply, the event loop runs meanwhile
+    bool reveal(QProcess &helper, const QStringList& paths);
+    QTemporaryDir root;
+    QProcess bus;
+    QString address;
+    QProcessEnvironment env;
+    bool sycoca_built = false;
+};
+
+void RevealTest::writeFile(const QString& path, const QByteArray& data)
+{
+    QDir().mkpath(QFileInfo(path).path());
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+void RevealTest::initTestCase()
+{
+    QString daemon = QStandardPaths::findExecutable(QStringLiteral("dbus-daemon"));
+    if(daemon.isEmpty())
+        QSKIP("dbus-daemon not found");
+    QVERIFY(root.isValid());
+
+    // No service directories, or the bus would start the real file manager
+    writeFile(root.path() + "/bus.conf",
+              "<busconfig>\n"
+              "  <type>session</type>\n"
+              "  <listen>unix:tmpdir=" + QFile::encodeName(root.path()) + "</listen>\n"
+              "  <auth>EXTERNAL</auth>\n"
+              "  <policy context=\"default\">\n"
+              "    <allow send_destination=\"*\"/>\n"
+              "    <allow own=\"*\"/>\n"
+              "  </policy>\n"
+              "</busconfig>\n");
+    bus.start(daemon, QStringList() << "--config-file=" + root.path() + "/bus.conf"
+                                    << "--nofork" << "--print-address");
+    QVERIFY(bus.waitForStarted());
+    while(!bus.canReadLine())
+        QVERIFY(bus.waitForReadyRead(TIMEOUT));
+    address = QString::fromUtf8(bus.readLine()).trimmed();
+    QVERIFY(!address.isEmpty());
+    QVERIFY(QDBusConnection::connectToBus(address, QStringLiteral("test")).isConnected());
+
+    // Only knows the fake file manager below, which records what it gets
+    env = QProcessEnvironment::systemEnvironment();
+    env.insert("DBUS_SESSION_BUS_ADDRESS", address);
+    env.insert("XDG_CONFIG_HOME", root.path() + "/config");
+    env.insert("XDG_CACHE_HOME", root.path() + "/cache");
+    env.insert("XDG_DATA_HOME", root.path() + "/data");
+    env.insert("XDG_CONFIG_DIRS", root.path() + "/etc");
+    env.insert("QT_QPA_PLATFORM", "offscreen");
+    env.remove("KDEHOME");
+    env.remove("KMOZILLAHELPER_SHARED");
+    writeFile(root.path() + "/filemanager.sh",
+              "#!/bin/sh\necho \"$@\" >> '" + QFile::encodeName(root.path()) + "/shown'\n");
+    QFile::setPermissions(root.path() + "/filemanager.sh", QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    writeFile(root.path() + "/data/applications/test-filemanager.desktop",
+              "[Desktop Entry]\nType=Application\nName=Test File Manager\n"
+              "Exec=" + QFile::encodeName(root.path()) + "/filemanager.sh %u\n"
+              "MimeType=inode/directory;\n");
+    writeFile(root.path() + "/config/mimeapps.list",
+              "[Default Applications]\ninode/directory=test-filemanager.desktop\n");
+    QVERIFY(QDir().mkpath(root.path() + "/first"));
+    QVERIFY(QDir().mkpath(root.path() + "/second"));
+    writeFile(root.path() + "/first/a.txt", "a");
+    writeFile(root.path() + "/second/b.txt", "b");
+
+    QString kbuildsycoca = QStandardPaths::findExecutable(QStringLiteral("kbuildsycoca5"));
+    if(kbuildsycoca.isEmpty())
+        return;
+    QProcess build;
+    build.setProcessEnvironment(env);
+    build.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    build.start(kbuildsycoca, QStringList() << "--noincremental");
+    QVERIFY(build.waitForFinished(60000));
+    sycoca_built = build.exitCode() == 0;
+}
+
+void RevealTest::cleanupTestCase()
+{
+    QDBusConnection::disconnectFromBus(QStringLiteral("test"));
+    bus.kill();
+    bus.waitForFinished();
+}
+
+bool RevealTest::startHelper(QProcess &helper)
+{
+    helper.setProcessEnvironment(env);
+    helper.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    helper.start(QStringLiteral(KMOZILLAHELPER_PATH), QStringList() << "--no-prewarm");
+    if(!helper.waitForStarted())
+        return false;
+    // Pipelined, so REVEAL is answered once it's done
+    helper.write("CHECK\n11\nPIPELINE\n\\E\n");
+    QByteArray line;
+    while(readLine(helper, line))
+    {
+        if(line == "\\1" || line == "\\0")
+            return line == "\\1";
+    }
+    return false;
+}
+
+bool RevealTest::readLine(QProcess &helper, QByteArray &line)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while(!helper.canReadLine())
+    {
+        if(helper.state() != QProcess::Running || timer.elapsed() > TIMEOUT)
+            return false;
+        QTest::qWait(10);
+    }
+    line = helper.readLine();
+    line.chop(1);
+    return true;
+}
+
+bool RevealTest::reveal(QProcess &helper, const QStringList& paths)
+{
+    QByteArray command = "1 REVEAL\n";
+    for(const QString &path : paths)
+        command += QFile::encodeName(path) + '\n';
+    helper.write(command + "\\E\n");
+    QByteArray line;
+    while(readLine(helper, line))
+    {
+        if(line == "\\1" || line == "\\0")
+            return line == "\\1";
+    }
+    return false;
+}
+
+void RevealTest::showItems()
+{
+    QDBusConnection connection(QStringLiteral("test"));
+    FakeFileManager fake;
+    QVERIFY(connection.registerObject(QStringLiteral("/org/freedesktop/FileManager1"), &fake,
+                                      QDBusConnection::ExportAllSlots));
+    QVERIFY(connection.registerService(QStringLiteral("org.freedesktop.FileManager1")));
+
+    QProcess helper;
+    QVERIFY(startHelper(helper));
+    const QStringList paths = QStringList() << root.path() + "/first/a.txt"
+                                            << root.path() + "/second/b.txt"
+                                            << root.path() + "/first";
+    QVERIFY(reveal(helper, paths));
+    helper.closeWriteChannel();
+    QVERIFY(helper.waitForFinished(TIMEOUT));
+
+    connection.unregisterService(QStringLiteral("org.freedesktop.FileManager1"));
+    connection.unregisterObject(QStringLiteral("/org/freedesktop/FileManager1"));
+
+    QCOMPARE(fake.calls.size(), 1);
+    QStringList uris;
+    for(const QString &path : paths)
+        uris << QUrl::fromLocalFile(path).toString();
+    QCOMPARE(fake.calls.first(), uris);
+    QVERIFY(!QFile::exists(root.path() + "/shown"));
+}
+
+void RevealTest::withoutFileManager1()
+{
+    if(!sycoca_built)
+        QSKIP("kbuildsycoca5 not found, the test file manager is unknown");
+
+    QProcess helper;
+    QVERIFY(startHelper(helper));
+    // ShowItems fails as nobody owns the name, each directory gets opened then
+    QVERIFY(reveal(helper, QStringList() << root.path() + "/first/a.txt"
+                                         << root.path() + "/second/b.txt"));
+    auto shown = [this]()
+    {
+        QFile file(root.path() + "/shown");
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+    QTRY_COMPARE_WITH_TIMEOUT(shown().count('\n'), 2, TIMEOUT);
+    QVERIFY2(shown().contains(QFile::encodeName(root.path() + "/first")), shown().constData());
+    QVERIFY2(shown().contains(QFile::encodeName(root.path() + "/second")), shown().constData());
+    helper.closeWriteChannel();
+    QVERIFY(helper.waitForFinished(TIMEOUT));
+}
+
+QTEST_GUILESS_MAIN(RevealTest)
+
+#include "revealtest.moc"
@@ -0,0 +1,356 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+/* Replays command scripts against a kmozillahelper running on a pipe and
+ * reports latency percentiles and throughput per command.
+ *
+ * Script format: one command per line, the command name and its arguments
+ * separated by tabs. Empty lines and lines starting with '#' are ignored.
+ * A line "@repeat N" repeats the following command N times.
+ *
+ * Unless --real-environment is given, the helper runs with XDG config, data and
+ * cache dirs in a temporary dir with a few known applications and proxy settings.
+ *
+ * The "first us" column is the latency of the first command of each kind. Runs
+ * with e.g. --idle 2000, once with and once without --cold, show how much
+ * prewarming saves there. */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QProcess>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+
+struct Command
+{
+    QString name;
+    QStringList arguments;
+};
+
+struct Samples
+{
+    std::vector<qint64> nsecs;
+    int failed = 0;
+};
+
+static QByteArray escape(const QString& line)
+{
+    QString escaped = line;
+    escaped.replace("\\", "\\\\");
+    escaped.replace("\n", "\\n");
+    return escaped.toUtf8();
+}
+
+static bool readScript(const QString& path, QList<Command> &commands)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        std::cerr << "Cannot open " << path.toStdString() << std::endl;
+        return false;
+    }
+    int repeat = 1;
+    QTextStream stream(&file);
+    while(!stream.atEnd())
+    {
+        QString line = stream.readLine();
+        if(line.isEmpty() || line.startsWith('#'))
+            continue;
+        if(line.startsWith("@repeat "))
+        {
+            repeat = qMax(1, line.mid(8).toInt());
+            continue;
+        }
+        QStringList fields = line.split('\t');
+        Command command;
+        command.name = fields.takeFirst();
+        command.arguments = fields;
+        for(; repeat > 0; --repeat)
+            commands << command;
+        repeat = 1;
+    }
+    return true;
+}
+
+static void writeFile(const QString& path, const QByteArray& data)
+{
+    QDir().mkpath(QFileInfo(path).path());
+    QFile file(path);
+    if(file.open(QIODevice::WriteOnly))
+        file.write(data);
+}
+
+/* Isolates the helper from the user's configuration: everything below the
+ * temporary dir, with a few known applications and a manual proxy setup.
+ * Only the system data dirs are kept, for the shared MIME database. */
+static QProcessEnvironment hermeticEnvironment(const QString& root)
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_CONFIG_HOME", root + "/config");
+    env.insert("XDG_CACHE_HOME", root + "/cache");
+    env.insert("XDG_DATA_HOME", root + "/data");
+    env.insert("XDG_CONFIG_DIRS", root + "/etc");
+    env.remove("KDEHOME");
+    // No display needed, nor the user's platform theme
+    env.insert("QT_QPA_PLATFORM", "offscreen");
+
+    writeFile(root + "/data/applications/bench-viewer.desktop",
+              "[Desktop Entry]\nType=Application\nName=Bench Viewer\nExec=bench-viewer %f\n"
+              "MimeType=application/pdf;text/plain;x-scheme-handler/bench;\n");
+    writeFile(root + "/data/applications/bench-mail.desktop",
+              "[Desktop Entry]\nType=Application\nName=Bench Mail\nExec=bench-mail %u\n"
+              "MimeType=x-scheme-handler/mailto;\n");
+    writeFile(root + "/config/mimeapps.list",
+              "[Default Applications]\napplication/pdf=bench-viewer.desktop\n"
+              "x-scheme-handler/mailto=bench-mail.desktop\n");
+    writeFile(root + "/config/kioslaverc",
+              "[Proxy Settings]\nProxyType=1\nhttpProxy=http://proxy.example 3128\n"
+              "httpsProxy=http://proxy.example 3128\nNoProxyFor=localhost,.example.org\n");
+
+    QString kbuildsycoca = QStandardPaths::findExecutable("kbuildsycoca5");
+    if(kbuildsycoca.isEmpty())
+    {
+        std::cerr << "kbuildsycoca5 not found, KSycoca will be built by the helper." << std::endl;
+        return env;
+    }
+    QProcess build;
+    build.setProcessEnvironment(env);
+    build.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    build.start(kbuildsycoca, QStringList() << "--noincremental");
+    build.waitForFinished(-1);
+    return env;
+}
+
+class Runner
+{
+public:
+    Runner(QProcess &helper) : helper(helper) {}
+    // Reads one reply, tag is the request ID or empty if not pipelined
+    bool readReply(QString &tag, bool &status);
+    void send(const Command& command, const QString& tag);
+private:
+    bool readLine(QByteArray &line);
+    QProcess &helper;
+};
+
+bool Runner::readLine(QByteArray &line)
+{
+    while(!helper.canReadLine())
+    {
+        if(!helper.waitForReadyRead(-1))
+            return false;
+    }
+    line = helper.readLine();
+    line.chop(1);
+    return true;
+}
+
+bool Runner::readReply(QString &tag, bool &status)
+{
+    tag.clear();
+    QByteArray line;
+    while(readLine(line))
+    {
+        if(line.startsWith("\\R"))
+            tag = QString::fromUtf8(line.mid(2));
+        else if(line == "\\1" || line == "\\0")
+        {
+            status = line == "\\1";
+            return true;
+        }
+    }
+    return false;
+}
+
+void Runner::send(const Command& command, const QString& tag)
+{
+    QByteArray frame;
+    if(!tag.isEmpty())
+        frame += tag.toUtf8() + ' ';
+    frame += escape(command.name) + '\n';
+    for(const QString &argument : command.arguments)
+        frame += escape(argument) + '\n';
+    frame += "\\E\n";
+    helper.write(frame);
+}
+
+static qint64 percentile(const std::vector<qint64>& sorted, double q)
+{
+    size_t index = size_t(std::ceil(q * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays command scripts against kmozillahelper");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scripts", "Command scripts to replay", "<script>...");
+    QCommandLineOption helperOption("helper", "Helper binary to run", "path", KMOZILLAHELPER_PATH);
+    QCommandLineOption iterationsOption("iterations", "How often to replay the scripts", "n", "10");
+    QCommandLineOption pipelineOption("pipeline", "Send each iteration at once with request IDs");
+    QCommandLineOption coldOption("cold", "Run the helper with --no-prewarm");
+    QCommandLineOption idleOption("idle", "Wait after CHECK, like a browser that is still starting", "ms", "0");
+    QCommandLineOption realEnvOption("real-environment", "Use the user's configuration instead of a hermetic one");
+    parser.addOption(helperOption);
+    parser.addOption(iterationsOption);
+    parser.addOption(pipelineOption);
+    parser.addOption(coldOption);
+    parser.addOption(idleOption);
+    parser.addOption(realEnvOption);
+    parser.process(app);
+
+    QList<Command> commands;
+    for(const QString &script : parser.positionalArguments())
+    {
+        if(!readScript(script, commands))
+            return 1;
+    }
+    if(commands.isEmpty())
+        parser.showHelp(1);
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const bool pipeline = parser.isSet(pipelineOption);
+
+    QTemporaryDir root;
+    QProcess helper;
+    helper.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    if(!parser.isSet(realEnvOption))
+        helper.setProcessEnvironment(hermeticEnvironment(root.path()));
+    QStringList helperArgs;
+    if(parser.isSet(coldOption))
+        helperArgs << "--no-prewarm";
+    helper.start(parser.value(helperOption), helperArgs);
+    if(!helper.waitForStarted())
+    {
+        std::cerr << "Cannot start " << parser.value(helperOption).toStdString() << std::endl;
+        return 1;
+    }
+
+    Runner runner(helper);
+    QString tag;
+    bool status = false;
+    Command check;
+    check.name = "CHECK";
+    check.arguments << "8";
+    if(pipeline)
+        check.arguments << "PIPELINE";
+    runner.send(check, QString());
+    if(!runner.readReply(tag, status) || !status)
+    {
+        std::cerr << "CHECK failed, helper too old?" << std::endl;
+        return 1;
+    }
+    // Gives the prewarmer its chance, the "first us" column shows the effect
+    QThread::msleep(qMax(0, parser.value(idleOption).toInt()));
+
+    std::map<QString, Samples> results;
+    QElapsedTimer timer;
+    QElapsedTimer total;
+    total.start();
+    for(int i = 0; i < iterations; ++i)
+    {
+        if(!pipeline)
+        {
+            for(const Command &command : commands)
+            {
+                timer.start();
+                runner.send(command, QString());
+                if(!runner.readReply(tag, status))
+                {
+                    std::cerr << "Helper exited" << std::endl;
+                    return 1;
+                }
+                Samples &samples = results[command.name];
+                samples.nsecs.push_back(timer.nsecsElapsed());
+                samples.failed += status ? 0 : 1;
+            }
+            continue;
+        }
+
+        // Everything at once, latency is from sending a command to its reply
+        QHash<QString, qint64> sent;
+        timer.start();
+        for(int id = 0; id < commands.size(); ++id)
+        {
+            sent.insert(QString::number(id), timer.nsecsElapsed());
+            runner.send(commands.at(id), QString::number(id));
+        }
+        for(int received = 0; received < commands.size(); ++received)
+        {
+            if(!runner.readReply(tag, status) || !sent.contains(tag))
+            {
+                std::cerr << "Helper exited or sent an unexpected reply" << std::endl;
+                return 1;
+            }
+            Samples &samples = results[commands.at(tag.toInt()).name];
+            samples.nsecs.push_back(timer.nsecsElapsed() - sent.value(tag));
+            samples.failed += status ? 0 : 1;
+        }
+    }
+    const double seconds = total.nsecsElapsed() / 1e9;
+
+    helper.closeWriteChannel();
+    helper.waitForFinished();
+
+    // Pipelined latencies overlap, only the total says something about throughput then
+    printf("%-24s %8s %6s %10s %10s %10s %10s", "command", "count", "failed", "first us", "p50 us", "p99 us", "max us");
+    if(pipeline)
+        printf("\n");
+    else
+        printf(" %12s\n", "cmds/s");
+    for(auto &result : results)
+    {
+        std::vector<qint64> &nsecs = result.second.nsecs;
+        const qint64 first = nsecs.front();
+        std::sort(nsecs.begin(), nsecs.end());
+        qint64 sum = 0;
+        for(qint64 n : nsecs)
+            sum += n;
+        printf("%-24s %8zu %6d %10.1f %10.1f %10.1f %10.1f", result.first.toUtf8().constData(),
+               nsecs.size(), result.second.failed, first / 1e3, percentile(nsecs, 0.5) / 1e3,
+               percentile(nsecs, 0.99) / 1e3, nsecs.back() / 1e3);
+        if(pipeline)
+            printf("\n");
+        else
+            printf(" %12.0f\n", sum > 0 ? nsecs.size() / (sum / 1e9) : 0.0);
+    }
+    printf("total: %d commands in %.3f s, %.0f commands/s\n", commands.size() * iterations,
+           seconds, commands.size() * iterations / seconds);
+    return 0;
+}
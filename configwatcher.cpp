@@ -0,0 +1,113 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "configwatcher.h"
+
+#include <QtCore/QStandardPaths>
+
+#include <KConfigCore/KConfig>
+#include <KConfigCore/KConfigGroup>
+#include <KConfigCore/KSharedConfig>
+
+// Default for how long further finished downloads are merged, in ms
+static const int DEFAULT_DOWNLOAD_WINDOW = 3000;
+
+ConfigWatcher::ConfigWatcher(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void ConfigWatcher::watch()
+{
+    if(current)
+        return;
+
+    current.reset(new Snapshot(read()));
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+    dir_watch.addFile(dir + QStringLiteral("/kdeglobals"));
+    dir_watch.addFile(dir + QStringLiteral("/emaildefaults"));
+    dir_watch.addFile(dir + QStringLiteral("/kmozillahelperrc"));
+    for(const QString &file : QStandardPaths::locateAll(QStandardPaths::AppDataLocation,
+                                                        QStringLiteral("kmozillahelper.notifyrc")))
+        dir_watch.addFile(file);
+    connect(&dir_watch, &KDirWatch::dirty, this, &ConfigWatcher::reload);
+    connect(&dir_watch, &KDirWatch::created, this, &ConfigWatcher::reload);
+    connect(&dir_watch, &KDirWatch::deleted, this, &ConfigWatcher::reload);
+}
+
+ConfigWatcher::SnapshotPtr ConfigWatcher::snapshot()
+{
+    watch();
+    return current;
+}
+
+void ConfigWatcher::setDefaultBrowser(const QString& browser)
+{
+    KSharedConfig::Ptr config = KSharedConfig::openConfig("kdeglobals");
+    KConfigGroup(config, "General").writeEntry("BrowserApplication", browser);
+    config->sync();
+    // Don't wait for KDirWatch, the browser may ask right away
+    if(current)
+        reload();
+}
+
+void ConfigWatcher::reload()
+{
+    SnapshotPtr previous = current;
+    current.reset(new Snapshot(read()));
+    if(current->browser != previous->browser)
+        emit defaultBrowserChanged();
+    if(current->mail_client != previous->mail_client || current->mail_in_terminal != previous->mail_in_terminal
+       || (current->mail_in_terminal && current->terminal != previous->terminal))
+        emit mailerChanged();
+}
+
+ConfigWatcher::Snapshot ConfigWatcher::read()
+{
+    Snapshot snapshot;
+
+    KSharedConfig::Ptr globals = KSharedConfig::openConfig("kdeglobals");
+    globals->reparseConfiguration();
+    KConfigGroup general(globals, "General");
+    snapshot.browser = general.readEntry("BrowserApplication");
+    snapshot.terminal = general.readPathEntry("TerminalApplication", "konsole");
+
+    // this is based on ktoolinvocation_x11.cpp, there is no API for this
+    KConfig email("emaildefaults");
+    QString groupname = KConfigGroup(&email, "Defaults").readEntry("Profile", "Default");
+    KConfigGroup profile(&email, QString("PROFILE_%1").arg(groupname));
+    snapshot.mail_client = profile.readPathEntry("EmailClient", QString());
+    snapshot.mail_in_terminal = profile.readEntry("TerminalClient", false);
+
+    // TODO cheat a bit due to i18n freeze - the strings are in the .notifyrc file,
+    // taken from KGet, but the notification itself needs the text too.
+    // So create it from there.
+    KConfig notifyrc("kmozillahelper.notifyrc", KConfig::FullConfig, QStandardPaths::AppDataLocation);
+    snapshot.download_comment = KConfigGroup(&notifyrc, "Event/downloadfinished").readEntry("Comment");
+
+    KSharedConfig::Ptr config = KSharedConfig::openConfig();
+    config->reparseConfiguration();
+    snapshot.download_window = KConfigGroup(config, "Notifications").readEntry("DownloadWindow", DEFAULT_DOWNLOAD_WINDOW);
+
+    return snapshot;
+}
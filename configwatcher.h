@@ -0,0 +1,66 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QSharedPointer>
+
+#include <KCoreAddons/KDirWatch>
+
+/* Keeps the values of the KDE settings the helper needs, read once into an
+ * immutable snapshot that is only rebuilt when one of the files changes, so
+ * commands using them don't touch the disk. Also tells when the values the
+ * browser cares about changed, not on every write to the files. */
+class ConfigWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    struct Snapshot
+    {
+        QString browser; // BrowserApplication from kdeglobals
+        QString terminal; // TerminalApplication from kdeglobals
+        QString mail_client; // from the default emaildefaults profile, may be empty
+        bool mail_in_terminal = false;
+        QString download_comment; // from kmozillahelper.notifyrc
+        int download_window = 0; // ms, from kmozillahelperrc
+    };
+    typedef QSharedPointer<const Snapshot> SnapshotPtr;
+    explicit ConfigWatcher(QObject *parent = nullptr);
+    // Reads the files and starts watching them, if not done yet
+    void watch();
+    SnapshotPtr snapshot();
+    void setDefaultBrowser(const QString& browser);
+signals:
+    void defaultBrowserChanged();
+    void mailerChanged();
+private slots:
+    void reload();
+private:
+    static Snapshot read();
+    KDirWatch dir_watch;
+    SnapshotPtr current;
+};
+
+#endif
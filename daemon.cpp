@@ -0,0 +1,270 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "daemon.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <iostream>
+
+// How long a shim waits for a freshly started daemon, in ms
+static const int DAEMON_START_TIMEOUT = 5000;
+static const int DAEMON_START_POLL = 50;
+
+std::string sharedSocketPath()
+{
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    if(!runtime || !*runtime)
+        return {};
+    return std::string(runtime) + "/kmozillahelper.socket";
+}
+
+static bool fillAddress(sockaddr_un &addr, const std::string &path)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path))
+        return false;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static int connectToDaemon(const std::string &path)
+{
+    sockaddr_un addr;
+    if(!fillAddress(addr, path))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+        return -1;
+    if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void startDaemon()
+{
+    pid_t child = fork();
+    if(child < 0)
+        return;
+    if(child > 0)
+    {
+        waitpid(child, nullptr, 0);
+        return;
+    }
+
+    // Double fork, so that the daemon is neither our child nor in the browser's session
+    setsid();
+    if(fork() != 0)
+        _exit(0);
+    // Must not keep the browser's pipes open
+    int null = open("/dev/null", O_RDWR);
+    if(null >= 0)
+    {
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        // Including stderr, or "firefox 2>&1 | tee log" would wait for us
+        dup2(null, STDERR_FILENO);
+        if(null > STDERR_FILENO)
+            close(null);
+    }
+    // Not a shim again
+    unsetenv("KMOZILLAHELPER_SHARED");
+    execl("/proc/self/exe", "kmozillahelper", "--daemon", static_cast<char*>(nullptr));
+    _exit(1);
+}
+
+static bool writeAll(int fd, const char *data, ssize_t len)
+{
+    while(len > 0)
+    {
+        ssize_t ret = write(fd, data, len);
+        if(ret < 0 && errno == EINTR)
+            continue;
+        if(ret <= 0)
+            return false;
+        data += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+int runShim()
+{
+    std::string path = sharedSocketPath();
+    if(path.empty())
+        return -1;
+
+    int sock = connectToDaemon(path);
+    if(sock < 0)
+    {
+        startDaemon();
+        for(int waited = 0; sock < 0 && waited < DAEMON_START_TIMEOUT; waited += DAEMON_START_POLL)
+        {
+            usleep(DAEMON_START_POLL * 1000);
+            sock = connectToDaemon(path);
+        }
+        if(sock < 0)
+            return -1;
+    }
+
+    // The daemon finds out who we are with SO_PEERCRED, so just forward everything
+    static char buf[64 * 1024];
+    pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { sock, POLLIN, 0 } };
+    for(;;)
+    {
+        if(poll(fds, 2, -1) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+        if(fds[0].revents)
+        {
+            ssize_t len = read(STDIN_FILENO, buf, sizeof(buf));
+            if(len > 0 && !writeAll(sock, buf, len))
+                break;
+            if(len == 0 || (len < 0 && errno != EINTR))
+            {
+                // Let the daemon answer what it already got, it closes the socket then
+                shutdown(sock, SHUT_WR);
+                fds[0].fd = -1;
+            }
+        }
+        if(fds[1].revents)
+        {
+            ssize_t len = read(sock, buf, sizeof(buf));
+            if(len < 0 && errno == EINTR)
+                continue;
+            if(len <= 0 || !writeAll(STDOUT_FILENO, buf, len))
+                break;
+        }
+    }
+    close(sock);
+    return 0;
+}
+
+DaemonServer::DaemonServer(QObject *parent)
+    : QObject(parent)
+    , lock_fd(-1)
+    , listen_fd(-1)
+    , notifier(nullptr)
+{
+}
+
+DaemonServer::~DaemonServer()
+{
+    stopListening();
+}
+
+void DaemonServer::stopListening()
+{
+    if(listen_fd < 0)
+        return;
+    // New shims fail to connect from now on and start another daemon,
+    // which needs the lock
+    unlink(path.c_str());
+    close(lock_fd);
+    lock_fd = -1;
+    // Shims that connected before are in the backlog, closing the socket
+    // would reset their connections
+    acceptConnection();
+    delete notifier;
+    notifier = nullptr;
+    close(listen_fd);
+    listen_fd = -1;
+}
+
+bool DaemonServer::listen()
+{
+    path = sharedSocketPath();
+    if(path.empty())
+    {
+        std::cerr << "XDG_RUNTIME_DIR is not set, cannot run as daemon." << std::endl;
+        return false;
+    }
+
+    // Only one daemon may own the socket, a leftover one from a crash is replaced
+    std::string lock_path = path + ".lock";
+    lock_fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if(lock_fd < 0 || flock(lock_fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        std::cerr << "KDE helper daemon already running." << std::endl;
+        return false;
+    }
+    unlink(path.c_str());
+
+    sockaddr_un addr;
+    if(!fillAddress(addr, path))
+        return false;
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if(listen_fd < 0)
+        return false;
+    mode_t mask = umask(0077);
+    int ret = bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    umask(mask);
+    if(ret != 0 || ::listen(listen_fd, SOMAXCONN) != 0)
+    {
+        std::cerr << "Cannot listen on " << path << ": " << strerror(errno) << std::endl;
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    notifier = new QSocketNotifier(listen_fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated,
+            this, &DaemonServer::acceptConnection);
+    return true;
+}
+
+void DaemonServer::acceptConnection()
+{
+    for(;;)
+    {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if(fd < 0)
+            return;
+
+        ucred cred;
+        socklen_t len = sizeof(cred);
+        if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || cred.uid != getuid())
+        {
+            close(fd);
+            continue;
+        }
+        emit newConnection(fd, cred.pid);
+    }
+}
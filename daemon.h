@@ -0,0 +1,67 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <string>
+
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+
+/* In shared mode, each browser process only runs a thin shim which forwards
+ * stdin and stdout to a single per-user helper daemon over a Unix socket.
+ * The daemon is started by the first shim and serves all browser processes,
+ * so the caches and loaded libraries are shared. */
+
+// Where the daemon listens, empty if there is no runtime directory
+std::string sharedSocketPath();
+
+// Forwards stdin/stdout to the daemon, starting it if necessary. Does not
+// need Qt. Returns the exit code, or -1 if the daemon is not reachable.
+int runShim();
+
+class DaemonServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DaemonServer(QObject *parent = nullptr);
+    ~DaemonServer();
+    // Fails if another daemon is already running
+    bool listen();
+    // Takes the connections that are already waiting and lets a new daemon
+    // take over the socket
+    void stopListening();
+signals:
+    // A browser connected, pid is the process on the other side (the shim)
+    void newConnection(int fd, qint64 pid);
+private slots:
+    void acceptConnection();
+private:
+    int lock_fd;
+    int listen_fd;
+    QSocketNotifier *notifier;
+    std::string path;
+};
+
+#endif
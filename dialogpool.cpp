@@ -0,0 +1,86 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "dialogpool.h"
+
+#include <QtCore/QTimer>
+#include <QtWidgets/QFileDialog>
+
+DialogPool::DialogPool(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DialogPool::~DialogPool()
+{
+    for(const QList<QFileDialog*> &pool : pools)
+        qDeleteAll(pool);
+}
+
+QFileDialog *DialogPool::take(Mode mode)
+{
+    if(pools[mode].isEmpty())
+        return create(mode);
+    return pools[mode].takeLast();
+}
+
+void DialogPool::release(Mode mode, QFileDialog *dialog)
+{
+    // QFileDialog has no way to forget the selection (selectFile() ignores an
+    // empty name), so a shown dialog isn't reused. Its results stay valid
+    // until the event loop runs again, then a fresh one takes its place.
+    dialog->deleteLater();
+    QTimer::singleShot(0, this, [this, mode]()
+    {
+        prewarm(mode);
+    });
+}
+
+void DialogPool::prewarm(Mode mode)
+{
+    if(pools[mode].isEmpty())
+        pools[mode].append(create(mode));
+}
+
+QFileDialog *DialogPool::create(Mode mode)
+{
+    QFileDialog *dialog = new QFileDialog;
+    switch(mode)
+    {
+    case OpenMode:
+        dialog->setAcceptMode(QFileDialog::AcceptOpen);
+        dialog->setFileMode(QFileDialog::ExistingFile);
+        break;
+    case SaveMode:
+        dialog->setAcceptMode(QFileDialog::AcceptSave);
+        dialog->setFileMode(QFileDialog::AnyFile);
+        dialog->setOption(QFileDialog::DontConfirmOverwrite, false);
+        break;
+    case DirectoryMode:
+        // Same as QFileDialog::getExistingDirectory(Url), but non-modal
+        dialog->setFileMode(QFileDialog::Directory);
+        dialog->setOption(QFileDialog::ShowDirsOnly, true);
+        break;
+    }
+    return dialog;
+}
@@ -0,0 +1,59 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef DIALOGPOOL_H
+#define DIALOGPOOL_H
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+
+class QFileDialog;
+
+/* Keeps a file dialog per mode ready, as creating one (the KDE file widget,
+ * the places model, icons, listing the start directory) can take seconds.
+ * Dialogs are never shown twice, a closed one is replaced by a new one
+ * while idle, so nothing of the previous use can show up in the next one. */
+class DialogPool : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode
+    {
+        OpenMode,
+        SaveMode,
+        DirectoryMode
+    };
+    explicit DialogPool(QObject *parent = nullptr);
+    ~DialogPool();
+    // A hidden dialog set up for mode, the caller sets title, directory etc.
+    QFileDialog *take(Mode mode);
+    // Hands a closed dialog back, it gets deleted and replaced
+    void release(Mode mode, QFileDialog *dialog);
+    // Creates a dialog for mode in advance, unless there is one already
+    void prewarm(Mode mode);
+private:
+    static QFileDialog *create(Mode mode);
+    QList<QFileDialog*> pools[DirectoryMode + 1];
+};
+
+#endif
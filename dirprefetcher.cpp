@@ -0,0 +1,128 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "dirprefetcher.h"
+
+#include <QtCore/QCoreApplication>
+
+#include <KConfigCore/KConfigGroup>
+#include <KConfigCore/KDesktopFile>
+#include <KIOCore/KCoreDirLister>
+#include <KIOCore/KRecentDocument>
+
+// How many directories are kept listed, and how many per application
+static const int MAX_LISTED = 8;
+static const int MAX_PER_APP = 4;
+// in ms, how long nothing has to happen before listing
+static const int IDLE_DELAY = 1000;
+
+DirPrefetcher::DirPrefetcher(QObject *parent)
+    : QObject(parent)
+{
+    timer.setSingleShot(true);
+    timer.setInterval(IDLE_DELAY);
+    connect(&timer, &QTimer::timeout, this, &DirPrefetcher::update);
+}
+
+void DirPrefetcher::start()
+{
+    started = true;
+    // KDE file dialogs add chosen files to the recent documents,
+    // under the name of the application showing them (us)
+    for(const QString &path : KRecentDocument::recentDocuments())
+    {
+        KDesktopFile file(path);
+        if(file.desktopGroup().readEntry("X-KDE-LastOpenedWith") != QCoreApplication::applicationName())
+            continue;
+        QUrl url(file.readUrl());
+        if(!url.isLocalFile())
+            continue;
+        QUrl dir = url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+        if(!documents.contains(dir))
+            documents.append(dir);
+        if(documents.size() >= MAX_LISTED)
+            break;
+    }
+    timer.start();
+}
+
+void DirPrefetcher::used(const QString& app, const QUrl& dir)
+{
+    // Listing remote dirs in the background could be expensive or ask for passwords
+    if(!dir.isLocalFile())
+        return;
+    QUrl clean = dir.adjusted(QUrl::StripTrailingSlash | QUrl::NormalizePathSegments);
+    QList<QUrl> &dirs = recent[app];
+    dirs.removeOne(clean);
+    dirs.prepend(clean);
+    if(dirs.size() > MAX_PER_APP)
+        dirs.removeLast();
+    if(started)
+        timer.start();
+}
+
+void DirPrefetcher::postpone()
+{
+    if(timer.isActive())
+        timer.start();
+}
+
+void DirPrefetcher::update()
+{
+    // Most recent directory of each application first, then the next ones
+    QList<QUrl> wanted;
+    for(int i = 0; i < MAX_PER_APP; ++i)
+    {
+        for(const QList<QUrl> &dirs : recent)
+        {
+            if(i < dirs.size() && !wanted.contains(dirs.at(i)))
+                wanted.append(dirs.at(i));
+        }
+    }
+    for(const QUrl &dir : documents)
+    {
+        if(!wanted.contains(dir))
+            wanted.append(dir);
+    }
+    wanted = wanted.mid(0, MAX_LISTED);
+
+    for(auto it = listers.begin(); it != listers.end();)
+    {
+        if(wanted.contains(it.key()))
+        {
+            ++it;
+            continue;
+        }
+        // KIO keeps the listing cached for a while longer on its own
+        delete it.value();
+        it = listers.erase(it);
+    }
+    for(const QUrl &dir : wanted)
+    {
+        if(listers.contains(dir))
+            continue;
+        KCoreDirLister *lister = new KCoreDirLister(this);
+        lister->openUrl(dir);
+        listers.insert(dir, lister);
+    }
+}
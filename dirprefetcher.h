@@ -0,0 +1,62 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef DIRPREFETCHER_H
+#define DIRPREFETCHER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <QtCore/QUrl>
+
+class KCoreDirLister;
+
+/* Keeps the listings of the directories file dialogs are likely to start in
+ * (the last ones used by each application, and those of documents recently
+ * chosen in our dialogs) in KIO's directory cache, so dialogs open on an
+ * already populated view. A KCoreDirLister holding a directory keeps its
+ * listing cached and updated through directory watches. Listing only
+ * starts once the helper is idle. */
+class DirPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DirPrefetcher(QObject *parent = nullptr);
+    // Looks at the recent documents and lists once idle, nothing happens before
+    void start();
+    // A dialog of app started in or returned something in dir
+    void used(const QString& app, const QUrl& dir);
+    // A command arrived, wait until things are quiet again
+    void postpone();
+private slots:
+    void update();
+private:
+    QHash<QString, QList<QUrl> > recent; // per application, most recent first
+    QList<QUrl> documents; // directories of recent documents
+    QHash<QUrl, KCoreDirLister*> listers;
+    QTimer timer;
+    bool started = false;
+};
+
+#endif
@@ -0,0 +1,65 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "downloadnotifier.h"
+
+#include <KI18n/KLocalizedString>
+#include <KNotifications/KNotification>
+
+DownloadNotifier::DownloadNotifier(ConfigWatcher& config, QObject *parent)
+    : QObject(parent)
+    , config(config)
+{
+    window.setSingleShot(true);
+    connect(&window, &QTimer::timeout, this, &DownloadNotifier::windowEnded);
+}
+
+void DownloadNotifier::downloadFinished(const QString& download)
+{
+    if(window.isActive())
+    {
+        pending.append(download);
+        return;
+    }
+    ConfigWatcher::SnapshotPtr snapshot = config.snapshot();
+    notify(download + " : " + snapshot->download_comment);
+    window.start(snapshot->download_window);
+}
+
+void DownloadNotifier::windowEnded()
+{
+    if(pending.isEmpty())
+        return;
+    if(pending.size() == 1)
+        notify(pending.first() + " : " + config.snapshot()->download_comment);
+    else
+        notify(i18np("%1 download finished", "%1 downloads finished", pending.size()));
+    pending.clear();
+    // Still at most one notification per window
+    window.start();
+}
+
+void DownloadNotifier::notify(const QString& text)
+{
+    KNotification::event("downloadfinished", text);
+}
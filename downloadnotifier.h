@@ -0,0 +1,53 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef DOWNLOADNOTIFIER_H
+#define DOWNLOADNOTIFIER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+
+#include "configwatcher.h"
+
+/* Shows the notifications for finished downloads. The first one is shown
+ * right away, further ones within the following window are merged into a
+ * single notification at its end, so saving many files at once doesn't flood
+ * the desktop. The window is "DownloadWindow" (ms) in the [Notifications]
+ * group of kmozillahelperrc. */
+class DownloadNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DownloadNotifier(ConfigWatcher& config, QObject *parent = nullptr);
+    void downloadFinished(const QString& download);
+private slots:
+    void windowEnded();
+private:
+    void notify(const QString& text);
+    ConfigWatcher& config;
+    QStringList pending;
+    QTimer window;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "executablecache.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
+
+#include <KService/KMimeTypeTrader>
+
+ExecutableCache::ExecutableCache(QObject *parent)
+    : QObject(parent)
+{
+    connect(&dir_watch, &KDirWatch::dirty, this, &ExecutableCache::clearPaths);
+    connect(&dir_watch, &KDirWatch::created, this, &ExecutableCache::clearPaths);
+    connect(&dir_watch, &KDirWatch::deleted, this, &ExecutableCache::clearPaths);
+}
+
+QString ExecutableCache::find(const QString& name)
+{
+    // Paths don't need $PATH
+    if(name.contains('/'))
+        return QStandardPaths::findExecutable(name);
+    if(!scanned)
+        scan();
+    return paths.value(name);
+}
+
+QString ExecutableCache::fileManager()
+{
+    if(!file_manager_known)
+    {
+        KService::Ptr service = KMimeTypeTrader::self()->preferredService("inode/directory", "Application");
+        file_manager = service ? service->exec().split(" ").first() : QString(); // only the actual command
+        file_manager_known = true;
+    }
+    return file_manager;
+}
+
+void ExecutableCache::clearPaths()
+{
+    paths.clear();
+    scanned = false;
+}
+
+void ExecutableCache::clearFileManager()
+{
+    file_manager.clear();
+    file_manager_known = false;
+}
+
+void ExecutableCache::scan()
+{
+    // Earlier directories in $PATH win, like for findExecutable
+    const QStringList dirs = QString::fromLocal8Bit(qgetenv("PATH")).split(':');
+    for(const QString &dir : dirs)
+    {
+        if(dir.isEmpty())
+            continue;
+        if(!dir_watch.contains(dir))
+            dir_watch.addDir(dir);
+        const QFileInfoList files = QDir(dir).entryInfoList(QDir::Files | QDir::Executable);
+        for(const QFileInfo &file : files)
+        {
+            if(!paths.contains(file.fileName()))
+                paths.insert(file.fileName(), file.absoluteFilePath());
+        }
+    }
+    scanned = true;
+}
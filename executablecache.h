@@ -0,0 +1,59 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef EXECUTABLECACHE_H
+#define EXECUTABLECACHE_H
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+
+#include <KCoreAddons/KDirWatch>
+
+/* Finds executables like QStandardPaths::findExecutable, but from an index
+ * built with one scan of $PATH instead of looking at every directory on each
+ * call. The index is dropped when anything in the directories changes. Also
+ * remembers which file manager handles directories until KSycoca changes. */
+class ExecutableCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ExecutableCache(QObject *parent = nullptr);
+    // Full path of the executable, empty if there is none
+    QString find(const QString& name);
+    // Command of the preferred application for directories, e.g. "dolphin"
+    QString fileManager();
+public slots:
+    // Connected to HandlerCache::changed, which follows KSycoca
+    void clearFileManager();
+private slots:
+    void clearPaths();
+private:
+    void scan();
+    QHash<QString, QString> paths; // name to full path
+    bool scanned = false;
+    QString file_manager;
+    bool file_manager_known = false;
+    KDirWatch dir_watch;
+};
+
+#endif
@@ -0,0 +1,361 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "handlercache.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QSet>
+#include <QtCore/QStandardPaths>
+
+#include <KI18n/KLocalizedString>
+#include <KIOCore/KProtocolInfo>
+#include <KService/KMimeTypeTrader>
+#include <KService/KSycoca>
+#include <KService/kservice_version.h>
+
+// How long to wait for more changes before looking at KSycoca, in ms
+static const int CHECK_DELAY = 2000;
+// How much of a file is used to recognize its content
+static const qint64 SNIFF_SIZE = 64 * 1024;
+
+HandlerCache::HandlerCache(QObject *parent)
+    : QObject(parent)
+    , current_generation(QDateTime::currentMSecsSinceEpoch())
+{
+    // Not connected with the PMF syntax, the signal got overloaded later
+    connect(KSycoca::self(), SIGNAL(databaseChanged(QStringList)),
+            this, SLOT(clear()));
+}
+
+void HandlerCache::clear()
+{
+    by_extension.clear();
+    by_type.clear();
+    by_scheme.clear();
+    by_exec.clear();
+    exec_indexed = false;
+    all_handlers.clear();
+    snapshot_built = false;
+    ++current_generation;
+    emit changed();
+}
+
+void HandlerCache::watch()
+{
+    if(watching)
+        return;
+    watching = true;
+
+    // KSycoca only looks for changes when it's used, so use it whenever the
+    // database or the files it is built from change. validate() is rate limited,
+    // so wait until a batch of changes (e.g. a package installation) is done.
+    check_timer.setSingleShot(true);
+    check_timer.setInterval(CHECK_DELAY);
+    connect(&check_timer, &QTimer::timeout, this, &HandlerCache::validate);
+
+    dir_watch.addFile(KSycoca::absoluteFilePath());
+    dir_watch.addFile(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+                      + QStringLiteral("/mimeapps.list"));
+    for(const QString &dir : QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation))
+        dir_watch.addDir(dir);
+    connect(&dir_watch, &KDirWatch::dirty, &check_timer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(&dir_watch, &KDirWatch::created, &check_timer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(&dir_watch, &KDirWatch::deleted, &check_timer, static_cast<void (QTimer::*)()>(&QTimer::start));
+}
+
+void HandlerCache::validate()
+{
+    // KSycoca only notices changes when it's used, which cache hits avoid.
+    // This is rate limited internally and emits databaseChanged if needed.
+#if KSERVICE_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    KSycoca::self()->ensureCacheValid();
+#endif
+}
+
+HandlerCache::MimeInfo HandlerCache::resolve(const QMimeType& mime)
+{
+    MimeInfo info;
+    info.known = mime.isValid();
+    if(!info.known)
+        return info;
+    info.name = mime.name();
+    info.comment = mime.comment();
+    if(KService::Ptr service = KMimeTypeTrader::self()->preferredService(info.name))
+        info.service = service->name();
+    return info;
+}
+
+HandlerCache::MimeInfo HandlerCache::mimeInfoForExtension(const QString& ext)
+{
+    validate();
+    return lookupExtension(ext);
+}
+
+HandlerCache::MimeInfo HandlerCache::mimeInfoForType(const QString& type)
+{
+    validate();
+    return lookupType(type);
+}
+
+HandlerCache::MimeInfo HandlerCache::mimeInfoForFile(const QString& path)
+{
+    // Magic rules only look at the start of a file, so map just that much
+    // instead of reading it, files may be huge downloads
+    QFile file(path);
+    QByteArray header;
+    qint64 size = qMin<qint64>(file.size(), SNIFF_SIZE);
+    if(size > 0 && file.open(QIODevice::ReadOnly))
+    {
+        if(uchar *data = file.map(0, size))
+            header = QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+    }
+    QString type = db.mimeTypeForFileNameAndData(path, header).name();
+    return mimeInfoForType(type);
+}
+
+HandlerCache::MimeInfo HandlerCache::handlerInfoForType(const QString& type)
+{
+    validate();
+    return lookupHandler(type);
+}
+
+HandlerCache::SchemeInfo HandlerCache::schemeInfo(const QString& scheme)
+{
+    validate();
+    return lookupScheme(scheme);
+}
+
+QVector<HandlerCache::MimeInfo> HandlerCache::mimeInfoForExtensions(const QStringList& exts)
+{
+    validate();
+    QVector<MimeInfo> infos;
+    infos.reserve(exts.size());
+    for(const QString &ext : exts)
+        infos.append(lookupExtension(ext));
+    return infos;
+}
+
+QVector<HandlerCache::MimeInfo> HandlerCache::handlerInfoForTypes(const QStringList& types)
+{
+    validate();
+    QVector<MimeInfo> infos;
+    infos.reserve(types.size());
+    for(const QString &type : types)
+        infos.append(lookupHandler(type));
+    return infos;
+}
+
+QVector<HandlerCache::SchemeInfo> HandlerCache::schemeInfos(const QStringList& schemes)
+{
+    validate();
+    QVector<SchemeInfo> infos;
+    infos.reserve(schemes.size());
+    for(const QString &scheme : schemes)
+        infos.append(lookupScheme(scheme));
+    return infos;
+}
+
+QVector<HandlerCache::MimeInfo> HandlerCache::snapshot(quint64 *generation)
+{
+    validate();
+    const quint64 started = current_generation;
+    if(generation)
+        *generation = started;
+    if(snapshot_built)
+        return all_handlers;
+
+    QVector<MimeInfo> handlers;
+
+    for(const QMimeType &mime : db.allMimeTypes())
+    {
+        MimeInfo info = lookupType(mime.name());
+        if(!info.service.isEmpty())
+            handlers.append(info);
+    }
+
+    // Schemes are only known from the services handling them
+    QSet<QString> schemes;
+    const QString prefix = QStringLiteral("x-scheme-handler/");
+    for(const KService::Ptr &service : KService::allServices())
+    {
+        for(const QString &type : service->serviceTypes())
+        {
+            if(type.startsWith(prefix))
+                schemes.insert(type.mid(prefix.size()));
+        }
+    }
+    for(const QString &protocol : KProtocolInfo::protocols())
+    {
+        if(KProtocolInfo::isHelperProtocol(protocol))
+            schemes.insert(protocol);
+    }
+    for(const QString &scheme : schemes)
+    {
+        MimeInfo info = lookupHandler(scheme);
+        if(!info.service.isEmpty())
+        {
+            info.name = prefix + scheme;
+            handlers.append(info);
+        }
+    }
+    // Only keep it if the walk didn't make KSycoca drop the caches halfway,
+    // the caller then has an outdated generation and asks again
+    if(current_generation == started)
+    {
+        all_handlers = handlers;
+        snapshot_built = true;
+    }
+    return handlers;
+}
+
+HandlerCache::MimeInfo HandlerCache::lookupExtension(const QString& ext)
+{
+    auto it = by_extension.constFind(ext);
+    if(it != by_extension.constEnd())
+    {
+        ++mime_stats.hits;
+        return *it;
+    }
+    ++mime_stats.misses;
+
+    MimeInfo info;
+    QList<QMimeType> mimeList = db.mimeTypesForFileName("foo." + ext);
+    for (const QMimeType &mime : mimeList)
+    {
+        if(mime.isValid())
+        {
+            info = resolve(mime);
+            break;
+        }
+    }
+    by_extension.insert(ext, info);
+    return info;
+}
+
+HandlerCache::MimeInfo HandlerCache::lookupType(const QString& type)
+{
+    auto it = by_type.constFind(type);
+    if(it != by_type.constEnd())
+    {
+        ++mime_stats.hits;
+        return *it;
+    }
+    ++mime_stats.misses;
+
+    MimeInfo info = resolve(db.mimeTypeForName(type));
+    by_type.insert(type, info);
+    return info;
+}
+
+HandlerCache::MimeInfo HandlerCache::lookupHandler(const QString& type)
+{
+    MimeInfo info = lookupType(type);
+    if(info.known)
+        return info;
+    // firefox also asks for protocol handlers using getfromtype
+    QString app = lookupScheme(type).app;
+    if(!app.isEmpty())
+    {
+        info.name = type;
+        info.comment = type; // TODO probably no way to find a good description
+        info.service = app;
+    }
+    return info;
+}
+
+HandlerCache::SchemeInfo HandlerCache::lookupScheme(const QString& scheme)
+{
+    // This used to be cached only for HANDLEREXISTS, to avoid causing
+    // Thunderbird to hang (https://bugzilla.suse.com/show_bug.cgi?id=1037806).
+    auto it = by_scheme.constFind(scheme);
+    if(it != by_scheme.constEnd())
+    {
+        ++scheme_stats.hits;
+        return *it;
+    }
+    ++scheme_stats.misses;
+
+    SchemeInfo info;
+    /* Inspired by kio's krun.cpp */
+    if(KService::Ptr service = KMimeTypeTrader::self()->preferredService(QLatin1String("x-scheme-handler/") + scheme))
+    {
+        info.exists = true;
+        info.app = service->name();
+    }
+    else if(KProtocolInfo::isHelperProtocol(scheme))
+    {
+        info.exists = true;
+        info.app = appForHelperProtocol(scheme);
+    }
+    by_scheme.insert(scheme, info);
+    return info;
+}
+
+QString HandlerCache::appForHelperProtocol(const QString& protocol)
+{
+    /* Some KDE services (e.g. vnc) also support application associations.
+     * Those are known as "Helper Protocols".
+     * However, those aren't also registered using fake mime types and there
+     * is no link to a .desktop file...
+     * So we need to query for the service to use and then find the .desktop
+     * file for that application by comparing the Exec values. */
+
+    QString exec = KProtocolInfo::exec(protocol);
+
+    if(exec.isEmpty())
+        return {};
+
+    if(exec.contains(' '))
+        exec = exec.split(' ').first(); // first part of command
+
+    if(KService::Ptr service = KService::serviceByDesktopName(exec))
+        return service->name();
+
+    QString servicename = serviceNameForExec(exec);
+
+    if(servicename.isEmpty() && exec == "kmailservice") // kmailto is handled internally by kmailservice
+        servicename = i18n("KDE");
+
+    return servicename;
+}
+
+QString HandlerCache::serviceNameForExec(const QString& exec)
+{
+    if(!exec_indexed)
+    {
+        // One pass over all services instead of one per lookup
+        const KService::List services = KService::allServices();
+        by_exec.reserve(services.size());
+        for(const KService::Ptr &service : services)
+        {
+            QString exec2 = service->exec();
+            if(exec2.contains(' '))
+                exec2 = exec2.split(' ').first(); // first part of command
+            if(!exec2.isEmpty() && !by_exec.contains(exec2))
+                by_exec.insert(exec2, service->name());
+        }
+        exec_indexed = true;
+    }
+    return by_exec.value(exec);
+}
@@ -0,0 +1,108 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef HANDLERCACHE_H
+#define HANDLERCACHE_H
+
+#include <QtCore/QHash>
+#include <QtCore/QMimeDatabase>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+#include <KCoreAddons/KDirWatch>
+
+#include "stats.h"
+
+/* Remembers the results of MIME type and handler lookups, as the browser asks
+ * for the same few extensions and types over and over again. Everything is
+ * dropped as soon as KSycoca reports a change, so the answers never get stale. */
+class HandlerCache : public QObject
+{
+    Q_OBJECT
+public:
+    struct MimeInfo
+    {
+        bool known = false; // whether the MIME type exists at all
+        QString name;
+        QString comment;
+        QString service; // name of the preferred application, empty if none
+    };
+    struct SchemeInfo
+    {
+        bool exists = false; // whether anything handles the scheme
+        QString app; // name of the handling application, empty if unknown
+    };
+    explicit HandlerCache(QObject *parent = nullptr);
+    MimeInfo mimeInfoForExtension(const QString& ext);
+    MimeInfo mimeInfoForType(const QString& type);
+    // Looks at the name and the first bytes of a local file
+    MimeInfo mimeInfoForFile(const QString& path);
+    // Like mimeInfoForType, but falls back to the handler of the scheme
+    MimeInfo handlerInfoForType(const QString& type);
+    SchemeInfo schemeInfo(const QString& scheme);
+    // Batch variants, checking for KSycoca changes only once
+    QVector<MimeInfo> mimeInfoForExtensions(const QStringList& exts);
+    QVector<MimeInfo> handlerInfoForTypes(const QStringList& types);
+    QVector<SchemeInfo> schemeInfos(const QStringList& schemes);
+    // Everything that has a handler: MIME types, then x-scheme-handler/<scheme>
+    // entries for schemes, described like handlerInfoForType does, and the
+    // generation it belongs to
+    QVector<MimeInfo> snapshot(quint64 *generation = nullptr);
+    const CacheStats *mimeStats() const { return &mime_stats; }
+    const CacheStats *schemeStats() const { return &scheme_stats; }
+    // Notices KSycoca changes when they happen, not only on the next lookup
+    void watch();
+signals:
+    void changed();
+private slots:
+    void clear();
+private:
+    void validate();
+    // Lookups without validate()
+    MimeInfo lookupExtension(const QString& ext);
+    MimeInfo lookupType(const QString& type);
+    MimeInfo lookupHandler(const QString& type);
+    SchemeInfo lookupScheme(const QString& scheme);
+    MimeInfo resolve(const QMimeType& mime);
+    QString appForHelperProtocol(const QString& protocol);
+    // Name of the first service whose Exec line runs the given command
+    QString serviceNameForExec(const QString& exec);
+    QMimeDatabase db;
+    QHash<QString, MimeInfo> by_extension;
+    QHash<QString, MimeInfo> by_type;
+    QHash<QString, SchemeInfo> by_scheme;
+    QHash<QString, QString> by_exec; // built on first use
+    bool exec_indexed = false;
+    QVector<MimeInfo> all_handlers; // built on first use
+    bool snapshot_built = false;
+    quint64 current_generation; // changes whenever the cache gets dropped, also across restarts
+    bool watching = false;
+    KDirWatch dir_watch;
+    QTimer check_timer;
+    CacheStats mime_stats;
+    CacheStats scheme_stats;
+};
+
+#endif
@@ -0,0 +1,62 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "launchqueue.h"
+
+#include <KIOWidgets/KRun>
+
+// More launches wait until one of these is done
+static const int MAX_RUNNING = 4;
+
+LaunchQueue::LaunchQueue(QObject *parent)
+    : QObject(parent)
+    , running(0)
+{
+}
+
+void LaunchQueue::open(const QUrl& url, const Callback& done)
+{
+    pending.enqueue({ url, done });
+    startNext();
+}
+
+void LaunchQueue::startNext()
+{
+    while(running < MAX_RUNNING && !pending.isEmpty())
+    {
+        Job job = pending.dequeue();
+        KRun *run = new KRun(job.url, NULL); // TODO parent
+        run->setAutoDelete(false);
+        run->setParent(this);
+        ++running;
+        // Emitted once in any case, after error() if it failed
+        connect(run, &KRun::finished, this, [this, run, job]()
+        {
+            run->deleteLater();
+            --running;
+            if(job.done)
+                job.done(!run->hasError());
+            startNext();
+        });
+    }
+}
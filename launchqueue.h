@@ -0,0 +1,54 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef LAUNCHQUEUE_H
+#define LAUNCHQUEUE_H
+
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QUrl>
+
+/* Opens URLs with KRun, at most a few at a time, and deletes each KRun as
+ * soon as it is done instead of keeping it around forever. The callback of a
+ * launch gets whether it worked. */
+class LaunchQueue : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(bool ok)> Callback;
+    explicit LaunchQueue(QObject *parent = nullptr);
+    void open(const QUrl& url, const Callback& done);
+private:
+    struct Job
+    {
+        QUrl url;
+        Callback done; // may be empty
+    };
+    void startNext();
+    QQueue<Job> pending;
+    int running;
+};
+
+#endif
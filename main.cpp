@@ -25,54 +25,95 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "main.h"
 
 #include <cassert>
+#include <csignal>
+#include <cstring>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 
 #include <QtCore/QCommandLineParser>
-#include <QtCore/QMimeDatabase>
+#include <QtCore/QFile>
 #include <QtCore/QHash>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusPendingCallWatcher>
 #include <QtGui/QIcon>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
 #include <QWindow>
 
-#include <KConfigCore/KConfigGroup>
-#include <KConfigCore/KSharedConfig>
 #include <KCoreAddons/KAboutData>
 #include <KCoreAddons/KShell>
 #include <KCoreAddons/KProcess>
 #include <KI18n/KLocalizedString>
-#include <KIOCore/KProtocolManager>
-#include <KIOCore/KRecentDocument>
+#include <KIOCore/KIO/DesktopExecParser>
 #include <KIOWidgets/KOpenWithDialog>
 #include <KIOWidgets/KRun>
-#include <KNotifications/KNotification>
-#include <KService/KMimeTypeTrader>
+#include <KService/KService>
 #include <KWindowSystem/KWindowSystem>
 
 //#define DEBUG_KDE
 
-#define HELPER_VERSION 6
+#define HELPER_VERSION 11
 #define APP_HELPER_VERSION "5.0.6"
 
+static QString appNameForProcess(qint64 pid)
+{
+    // Check whether we're called from Firefox or Thunderbird
+    QString parent = QFile::symLinkTarget(QStringLiteral("/proc/%1/exe").arg(pid));
+    if(parent.contains("thunderbird", Qt::CaseInsensitive))
+        return i18n("Mozilla Thunderbird");
+    return i18n("Mozilla Firefox");
+}
+
+static qint64 parentPid(qint64 pid)
+{
+    // The fourth field of /proc/<pid>/stat, after the parenthesized command name
+    QFile stat(QStringLiteral("/proc/%1/stat").arg(pid));
+    if(!stat.open(QIODevice::ReadOnly))
+        return 0;
+    QByteArray data = stat.readAll();
+    QList<QByteArray> fields = data.mid(data.lastIndexOf(')') + 2).split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() : 0;
+}
+
+static bool sharedModeRequested(int argc, char* argv[])
+{
+    bool shared = qEnvironmentVariableIntValue("KMOZILLAHELPER_SHARED") != 0;
+    for(int i = 1; i < argc; ++i)
+    {
+        // The daemon inherits the environment of the first browser
+        if(strcmp(argv[i], "--daemon") == 0)
+            return false;
+        if(strcmp(argv[i], "--shared") == 0)
+            shared = true;
+    }
+    return shared;
+}
+
 int main(int argc, char* argv[])
 {
     // Avoid getting started by the session manager
     qunsetenv("SESSION_MANAGER");
 
+    // Only forward to the shared daemon, without loading anything.
+    // If that doesn't work, just do the work ourselves.
+    if(sharedModeRequested(argc, argv))
+    {
+        int ret = runShim();
+        if(ret >= 0)
+            return ret;
+    }
+
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling, true);
 
     QApplication app(argc, argv);
 
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps, true);
 
-    // Check whether we're called from Firefox or Thunderbird
-    QString appname = i18n("Mozilla Firefox");
-    QString parent = QFile::symLinkTarget(QStringLiteral("/proc/%1/exe").arg(int(getppid())));
-    if(parent.contains("thunderbird", Qt::CaseInsensitive))
-        appname = i18n("Mozilla Thunderbird");
+    QString appname = appNameForProcess(getppid());
 
     // This shows on file dialogs
     KAboutData about("kmozillahelper", appname, APP_HELPER_VERSION);
@@ -82,43 +123,278 @@ int main(int argc, char* argv[])
 
     QCommandLineParser parser;
     about.setupCommandLine(&parser);
+    QCommandLineOption noPrewarmOption(QStringLiteral("no-prewarm"),
+                                       i18n("Do not load dialogs and databases in advance"));
+    parser.addOption(noPrewarmOption);
+    QCommandLineOption sharedOption(QStringLiteral("shared"),
+                                    i18n("Forward to a helper shared by all browser processes"));
+    parser.addOption(sharedOption);
+    QCommandLineOption daemonOption(QStringLiteral("daemon"),
+                                    i18n("Run as the helper shared by all browser processes"));
+    parser.addOption(daemonOption);
+    QCommandLineOption traceOption(QStringLiteral("trace"),
+                                   i18n("Record all commands and replies into <file>"), QStringLiteral("file"));
+    parser.addOption(traceOption);
+    parser.process(app);
+    about.processCommandLine(&parser);
 
     app.setQuitOnLastWindowClosed(false);
 
     Helper helper;
+    // The browser can't pass arguments, so this can be set in the environment as well
+    QString trace = parser.isSet(traceOption) ? parser.value(traceOption)
+                                              : QFile::decodeName(qgetenv("KMOZILLAHELPER_TRACE"));
+    if(!trace.isEmpty() && !helper.startTrace(trace))
+        return 1;
+
+    DaemonServer server;
+    if(parser.isSet(daemonOption))
+    {
+        // Clients may disconnect at any time
+        signal(SIGPIPE, SIG_IGN);
+        if(!server.listen())
+            return 1;
+        helper.serve(&server);
+    }
+    else
+        helper.addClient(STDIN_FILENO, STDOUT_FILENO, appname);
+
+    if(!parser.isSet(noPrewarmOption))
+        helper.prewarm();
 
     app.installEventFilter(&helper);
 
     return app.exec();
 }
 
+// How long the daemon keeps running without clients, in ms
+static const int DAEMON_IDLE_TIMEOUT = 10 * 60 * 1000;
+// Size of the trace ring buffer, older records get overwritten
+static const quint64 TRACE_SIZE = 16 * 1024 * 1024;
+
+Helper::Client::Client(int infd, int outfd, const QString& appname)
+    : transport(infd, outfd)
+    , appname(appname)
+{
+}
+
 Helper::Helper()
-    : notifier(STDIN_FILENO, QSocketNotifier::Read)
+    : last_client_id(0)
+    , shared(false)
+    , downloads(config)
+    , prewarmer(handlers, dialogs)
     , arguments_read(false)
+    , wid(0)
+    , request(nullptr)
 {
-    connect(&notifier, &QSocketNotifier::activated,
-            this, &Helper::readCommand);
+    idle_timer.setSingleShot(true);
+    idle_timer.setInterval(DAEMON_IDLE_TIMEOUT);
+    stats.addCache(QStringLiteral("mime"), handlers.mimeStats());
+    stats.addCache(QStringLiteral("scheme"), handlers.schemeStats());
+    stats.addCache(QStringLiteral("proxy"), proxies.cacheStats());
+    stats.addCache(QStringLiteral("pac"), proxies.pacStats());
+    stats.installSignalHandler();
+
+    connect(&handlers, &HandlerCache::changed, &executables, &ExecutableCache::clearFileManager);
+    connect(&handlers, &HandlerCache::changed, this, [this]()
+    {
+        broadcastEvent(QStringLiteral("HANDLERS_CHANGED"));
+    });
+    connect(&proxies, &ProxyCache::changed, this, [this]()
+    {
+        broadcastEvent(QStringLiteral("PROXY_CHANGED"));
+    });
+    connect(&config, &ConfigWatcher::defaultBrowserChanged, this, [this]()
+    {
+        broadcastEvent(QStringLiteral("DEFAULTBROWSER_CHANGED"));
+    });
+    connect(&config, &ConfigWatcher::mailerChanged, this, [this]()
+    {
+        broadcastEvent(QStringLiteral("MAILER_CHANGED"));
+    });
 }
 
-void Helper::readCommand()
+void Helper::addClient(int infd, int outfd, const QString& appname)
 {
-    QString command = readLine();
-    if(!std::cin.good())
+    Client *client = new Client(infd, outfd, appname);
+    client->setParent(this);
+    client->id = ++last_client_id;
+    clients.append(client);
+    idle_timer.stop();
+    connect(&client->transport, &Transport::readyRead, this, [this, client]()
     {
+        readCommand(client);
+    });
+    connect(&client->transport, &Transport::closed, this, [this, client]()
+    {
+        removeClient(client);
+    });
+}
+
+bool Helper::startTrace(const QString& path)
+{
+    return trace.open(path, TRACE_SIZE);
+}
+
+void Helper::serve(DaemonServer *server)
+{
+    shared = true;
+    connect(server, &DaemonServer::newConnection, this, [this](int fd, qint64 pid)
+    {
+        // pid is the shim, the browser is its parent
+        addClient(fd, fd, appNameForProcess(parentPid(pid)));
+        clients.last()->transport.setCloseOnDelete(true);
+    });
+    connect(&idle_timer, &QTimer::timeout, this, [this, server]()
+    {
+        // A shim may have connected just now, it still gets served
+        server->stopListening();
+        shared = false;
+        if(!clients.isEmpty())
+            return;
 #ifdef DEBUG_KDE
-        std::cerr << "EOF, exiting." << std::endl;
+        std::cerr << "Idle, exiting." << std::endl;
 #endif
         QCoreApplication::exit();
+    });
+    idle_timer.start();
+}
+
+void Helper::removeClient(Client *client)
+{
+    clients.removeOne(client);
+    // Called from the transport, so it can't be deleted right now
+    client->deleteLater();
+    if(!clients.isEmpty())
         return;
+    if(shared)
+    {
+        idle_timer.start();
+        return;
+    }
+#ifdef DEBUG_KDE
+    std::cerr << "EOF, exiting." << std::endl;
+#endif
+    QCoreApplication::exit();
+}
+
+void Helper::broadcastEvent(const QString& event)
+{
+#ifdef DEBUG_KDE
+    std::cerr << "EVENT: " << event.toStdString() << std::endl;
+#endif
+    for(Client *client : clients)
+    {
+        if(client->events)
+            client->transport.writeEvent(event);
     }
+}
 
-    /* Allow multiple commands at once.
-       Firefox nests the event loop in the same way we do,
-       so if a file dialog is open, another command may arrive which we handle
-       in our nested event loop...
-    // For now we only allow one command at once.
-    // We need to do this as dialogs spawn their own eventloop and thus they get nested...
-    notifier.setEnabled(false); */
+/* Protocol description:
+   Each command is a line with the command name, followed by one line per argument
+   and terminated by a "\E" line. The reply consists of any number of lines
+   followed by the status line "\1" (success) or "\0" (failure).
+   Backslashes and newlines in arguments and reply lines are escaped.
+
+   Version 7 adds pipelining, enabled by passing "PIPELINE" to CHECK after
+   the version number. From then on each command line is prefixed by a numeric
+   request ID ("17 GETPROXY") and each reply is preceded by the line "\R17".
+   Replies are written as a whole, but not necessarily in the order the commands
+   arrived: dialogs run non-modally, so other commands are answered while they are open.
+
+   Version 8 adds binary framing, enabled by passing "BINARY" to CHECK. The reply to
+   CHECK itself is still sent as text. Afterwards a command is a 32 bit big endian
+   field count followed by that many fields, each a 32 bit big endian length and
+   UTF-8 data: the command line (including the request ID if pipelined) and the
+   arguments, without any escaping. A reply has the same layout with the fields
+   request ID (empty if not pipelined), status (a single byte 1 or 0) and the reply lines.
+
+   Version 9 adds the batch commands GETFROMEXTENSIONS, GETFROMTYPES and HANDLERSEXIST,
+   taking any number of keys as arguments. The reply has a fixed number of lines per key,
+   starting with "1" or "0" for the status the single command would have had: GETFROMEXTENSIONS
+   and GETFROMTYPES add the lines of GETFROMEXTENSION and GETFROMTYPE (empty on failure),
+   HANDLERSEXIST nothing.
+
+   GETHANDLERSNAPSHOT, also new in version 9, replies with a generation number followed
+   by three lines (type, description, application) for everything GETFROMTYPE would find
+   an application for, including "x-scheme-handler/<scheme>" entries. With the arguments
+   "SINCE" and a generation number it only replies with the generation if it is unchanged.
+
+   Version 10 adds events, enabled by passing "EVENTS" to CHECK (after "PIPELINE" and
+   "BINARY", if given). The helper then sends unsolicited "\EVENT <name>" lines between
+   replies, in binary framing a frame with the single field "EVENT <name>". The names are
+   HANDLERS_CHANGED (MIME types, applications or scheme handlers), PROXY_CHANGED,
+   DEFAULTBROWSER_CHANGED and MAILER_CHANGED, so clients can keep previous answers until then.
+
+   In pipelined mode, OPEN and REVEAL are answered once the launch is done, with its result,
+   so the request ID identifies the launch. Otherwise they are answered right away.
+
+   Version 11 allows any number of paths for REVEAL. They are shown with one call to
+   org.freedesktop.FileManager1.ShowItems on the session bus, or if that fails, one by one. */
+
+void Helper::prewarm()
+{
+    prewarmer.start();
+    directories.start();
+}
+
+void Helper::readCommand(Client *client)
+{
+    QStringList frame;
+    while(client->transport.readFrame(frame))
+    {
+        prewarmer.postpone();
+        directories.postpone();
+
+        if(frame.isEmpty())
+        {
+            std::cerr << "Missing command for KDE helper." << std::endl;
+            continue;
+        }
+        QString command = frame.takeFirst();
+
+        QString tag;
+        if(client->pipelined)
+        {
+            int sep = command.indexOf(' ');
+            tag = command.left(sep);
+            bool valid = sep > 0;
+            for(const QChar &c : tag)
+                valid = valid && c.isDigit();
+            if(!valid)
+            {
+                // Drop it, a reply couldn't be matched anyway
+                std::cerr << "Missing request ID for KDE helper: " << command.toStdString() << std::endl;
+                continue;
+            }
+            command = command.mid(sep + 1);
+        }
+
+        arguments = frame;
+        arguments_read = false;
+        runCommand(client, command, tag);
+        arguments.clear();
+    }
+}
+
+void Helper::runCommand(Client *client, const QString& command, const QString& tag)
+{
+    Request *req = new Request;
+    req->client = client;
+    req->client_id = client->id;
+    req->tag = tag;
+    req->command = command;
+    req->timer.start();
+    if(trace.isEnabled())
+        trace.record(TraceCommand, client->id, true, tag, command, arguments);
+
+    // Dialogs show the name of the browser they belong to
+    if(QApplication::applicationDisplayName() != client->appname)
+        QApplication::setApplicationDisplayName(client->appname);
+
+    // Some handlers may spawn a nested event loop (e.g. KRun error messages)
+    Request *previous = request;
+    request = req;
 
 #ifdef DEBUG_KDE
     std::cerr << "COMMAND: " << command.toStdString() << std::endl;
@@ -134,6 +410,14 @@ void Helper::readCommand()
         status = handleGetFromExtension();
     else if(command == "GETFROMTYPE")
         status = handleGetFromType();
+    else if(command == "HANDLERSEXIST")
+        status = handleHandlersExist();
+    else if(command == "GETFROMEXTENSIONS")
+        status = handleGetFromExtensions();
+    else if(command == "GETFROMTYPES")
+        status = handleGetFromTypes();
+    else if(command == "GETHANDLERSNAPSHOT")
+        status = handleGetHandlerSnapshot();
     else if(command == "GETAPPDESCFORSCHEME")
         status = handleGetAppDescForScheme();
     else if(command == "APPSDIALOG")
@@ -168,17 +452,46 @@ void Helper::readCommand()
         status = handleSetDefaultBrowser();
     else if(command == "DOWNLOADFINISHED")
         status = handleDownloadFinished();
+    else if(command == "STATS")
+        status = handleStats();
     else
     {
         std::cerr << "Unknown command for KDE helper: " << command.toStdString() << std::endl;
+        req->command = QStringLiteral("(unknown)"); // don't let garbage fill the statistics
         status = false;
     }
-    // status done as \1 (==ok) and \0 (==not ok), because otherwise this cannot happen
-    // in normal data (\ is escaped otherwise)
-    outputLine(status ? "\\1" : "\\0", false); // do not escape
 
-    /* See comment on setEnabled above
-    notifier.setEnabled(true); */
+    request = previous;
+
+    // Dialogs send their reply once they are closed
+    if(!req->deferred)
+        finishRequest(req, status);
+
+    if(client->binary_pending)
+    {
+        client->binary_pending = false;
+        client->transport.setFraming(Transport::BinaryFraming);
+    }
+}
+
+Helper::Request *Helper::deferReply()
+{
+    request->deferred = true;
+    return request;
+}
+
+void Helper::finishRequest(Request *req, bool status)
+{
+    stats.record(req->command, status, req->timer.nsecsElapsed());
+    if(trace.isEnabled())
+        trace.record(TraceReply, req->client_id, status, req->tag, req->command, req->reply);
+#ifdef DEBUG_KDE
+    for(const QString &line : req->reply)
+        std::cerr << "OUTPUT: " << line.toStdString() << std::endl;
+#endif
+    if(req->client)
+        req->client->transport.writeReply(req->tag, req->reply, status);
+    delete req;
 }
 
 bool Helper::handleCheck()
@@ -186,12 +499,29 @@ bool Helper::handleCheck()
     if(!readArguments(1))
         return false;
     int version = getArgument().toInt(); // requested version
+    bool pipeline = isArgument("PIPELINE");
+    bool binary = isArgument("BINARY");
+    bool events = isArgument("EVENTS");
     if(!allArgumentsUsed())
         return false;
-    if(version <= HELPER_VERSION) // we must have the exact requested version
-        return true;
-    std::cerr << "KDE helper version too old." << std::endl;
-    return false;
+    if(version > HELPER_VERSION) // we must have the exact requested version
+    {
+        std::cerr << "KDE helper version too old." << std::endl;
+        return false;
+    }
+    // Takes effect with the next command, this reply is still untagged
+    if(pipeline)
+        request->client->pipelined = true;
+    // Switched in runCommand, after the reply was written as text
+    if(binary)
+        request->client->binary_pending = true;
+    if(events)
+    {
+        request->client->events = true;
+        handlers.watch();
+        config.watch();
+    }
+    return true;
 }
 
 bool Helper::handleGetProxy()
@@ -201,42 +531,18 @@ bool Helper::handleGetProxy()
     QUrl url = QUrl::fromUserInput(getArgument());
     if(!allArgumentsUsed())
         return false;
-    QString proxy;
-    KProtocolManager::slaveProtocol(url, proxy);
-    if(proxy.isEmpty() || proxy == "DIRECT") // TODO return DIRECT if empty?
-    {
-        outputLine("DIRECT");
-        return true;
-    }
-    QUrl proxyurl = QUrl::fromUserInput(proxy);
-    if(proxyurl.isValid())
-    { // firefox wants this format
-        outputLine("PROXY" " " + proxyurl.host() + ":" + QString::number(proxyurl.port()));
-        // TODO there is also "SOCKS " type
-        return true;
-    }
-    return false;
+    outputLine(proxies.proxyFor(url));
+    return true;
 }
 
 bool Helper::handleHandlerExists()
 {
-    // Cache protocols types to avoid causing Thunderbird to hang (https://bugzilla.suse.com/show_bug.cgi?id=1037806).
-    static QHash<QString,bool> known_protocols;
-
     if(!readArguments(1))
         return false;
     QString protocol = getArgument();
     if(!allArgumentsUsed())
         return false;
-
-    auto it(known_protocols.find(protocol));
-    if(it == known_protocols.end())
-        it = known_protocols.insert(protocol, KProtocolInfo::isHelperProtocol(protocol));
-
-    if(*it)
-        return true;
-
-    return KMimeTypeTrader::self()->preferredService(QLatin1String("x-scheme-handler/") + protocol) != nullptr;
+    return handlers.schemeInfo(protocol).exists;
 }
 
 bool Helper::handleGetFromExtension()
@@ -247,12 +553,7 @@ bool Helper::handleGetFromExtension()
     if(!allArgumentsUsed())
         return false;
     if(!ext.isEmpty())
-    {
-        QList<QMimeType> mimeList = QMimeDatabase().mimeTypesForFileName("foo." + ext);
-        for (const QMimeType &mime : mimeList)
-            if(mime.isValid())
-                return writeMimeInfo(mime);
-    }
+        return writeMimeInfo(handlers.mimeInfoForExtension(ext));
     return false;
 }
 
@@ -263,34 +564,90 @@ bool Helper::handleGetFromType()
     QString type = getArgument();
     if(!allArgumentsUsed())
         return false;
-    QMimeType mime = QMimeDatabase().mimeTypeForName(type);
-    if(mime.isValid())
-        return writeMimeInfo(mime);
-    // firefox also asks for protocol handlers using getfromtype
-    QString app = getAppForProtocol(type);
-    if(!app.isEmpty())
+    return writeMimeInfo(handlers.handlerInfoForType(type));
+}
+
+bool Helper::handleHandlersExist()
+{
+    if(!readArguments(1))
+        return false;
+    for(const HandlerCache::SchemeInfo &scheme : handlers.schemeInfos(getAllArguments()))
+        outputLine(scheme.exists ? "1" : "0");
+    return allArgumentsUsed();
+}
+
+bool Helper::handleGetFromExtensions()
+{
+    if(!readArguments(1))
+        return false;
+    QStringList exts = getAllArguments();
+    QVector<HandlerCache::MimeInfo> mimes = handlers.mimeInfoForExtensions(exts);
+    for(int i = 0; i < exts.size(); ++i)
     {
-        outputLine(type);
-        outputLine(type); // TODO probably no way to find a good description
-        outputLine(app);
-        return true;
+        if(exts[i].isEmpty())
+            mimes[i] = HandlerCache::MimeInfo();
+        writeMimeItem(mimes[i]);
     }
-    return false;
+    return allArgumentsUsed();
 }
 
-bool Helper::writeMimeInfo(QMimeType mime)
+bool Helper::handleGetFromTypes()
 {
-    KService::Ptr service = KMimeTypeTrader::self()->preferredService(mime.name());
-    if(service)
+    if(!readArguments(1))
+        return false;
+    for(const HandlerCache::MimeInfo &mime : handlers.handlerInfoForTypes(getAllArguments()))
+        writeMimeItem(mime);
+    return allArgumentsUsed();
+}
+
+bool Helper::writeMimeInfo(const HandlerCache::MimeInfo& mime)
+{
+    if(!mime.service.isEmpty())
     {
-        outputLine(mime.name());
-        outputLine(mime.comment());
-        outputLine(service->name());
+        outputLine(mime.name);
+        outputLine(mime.comment);
+        outputLine(mime.service);
         return true;
     }
     return false;
 }
 
+bool Helper::handleGetHandlerSnapshot()
+{
+    if(!readArguments(0))
+        return false;
+    bool since = isArgument("SINCE");
+    if(since && !readArguments(1))
+        return false;
+    QString known = since ? getArgument() : QString();
+    if(!allArgumentsUsed())
+        return false;
+    // Both from the same check for KSycoca changes
+    quint64 current;
+    const QVector<HandlerCache::MimeInfo> all = handlers.snapshot(&current);
+    QString generation = QString::number(current);
+    outputLine(generation);
+    if(since && known == generation)
+        return true;
+    for(const HandlerCache::MimeInfo &mime : all)
+    {
+        outputLine(mime.name);
+        outputLine(mime.comment);
+        outputLine(mime.service);
+    }
+    return true;
+}
+
+void Helper::writeMimeItem(const HandlerCache::MimeInfo& mime)
+{
+    // Same lines as writeMimeInfo, but always exactly four
+    bool found = !mime.service.isEmpty();
+    outputLine(found ? "1" : "0");
+    outputLine(found ? mime.name : QString());
+    outputLine(found ? mime.comment : QString());
+    outputLine(mime.service);
+}
+
 bool Helper::handleGetAppDescForScheme()
 {
     if(!readArguments(1))
@@ -298,7 +655,7 @@ bool Helper::handleGetAppDescForScheme()
     QString scheme = getArgument();
     if(!allArgumentsUsed())
         return false;
-    QString app = getAppForProtocol(scheme);
+    QString app = handlers.schemeInfo(scheme).app;
     if(!app.isEmpty())
     {
         outputLine(app);
@@ -315,36 +672,43 @@ bool Helper::handleAppsDialog()
     long wid = getArgumentParent();
     if(!allArgumentsUsed())
         return false;
-    KOpenWithDialog dialog(NULL);
+    KOpenWithDialog *dialog = new KOpenWithDialog(NULL);
     if(!title.isEmpty())
-        dialog.setWindowTitle(title);
-    dialog.hideNoCloseOnExit();
-    dialog.hideRunInTerminal(); // TODO
+        dialog->setWindowTitle(title);
+    dialog->hideNoCloseOnExit();
+    dialog->hideRunInTerminal(); // TODO
     if(wid != 0)
     {
-        dialog.setAttribute(Qt::WA_NativeWindow, true);
-        QWindow *subWindow = dialog.windowHandle();
+        dialog->setAttribute(Qt::WA_NativeWindow, true);
+        QWindow *subWindow = dialog->windowHandle();
         if(subWindow)
             KWindowSystem::setMainWindow(subWindow, wid);
     }
-    if(dialog.exec())
+
+    Request *req = deferReply();
+    connect(dialog, &QDialog::finished, this, [this, dialog, req](int code)
     {
-        KService::Ptr service = dialog.service();
+        dialog->deleteLater();
+        if(code != QDialog::Accepted)
+            return finishRequest(req, false);
+
+        KService::Ptr service = dialog->service();
         QString command;
         if(service)
             command = service->exec();
-        else if(!dialog.text().isEmpty())
-            command = dialog.text();
+        else if(!dialog->text().isEmpty())
+            command = dialog->text();
         else
-            return false;
+            return finishRequest(req, false);
         command = command.split(" ").first(); // only the actual command
-        command = QStandardPaths::findExecutable(command);
+        command = executables.find(command);
         if(command.isEmpty())
-            return false;
-        outputLine(QUrl::fromUserInput(command).url());
-        return true;
-    }
-    return false;
+            return finishRequest(req, false);
+        req->reply.append(QUrl::fromUserInput(command).url());
+        finishRequest(req, true);
+    });
+    dialog->open();
+    return true;
 }
 
 QStringList Helper::convertToNameFilters(const QString &input)
@@ -384,58 +748,73 @@ bool Helper::handleGetOpenOrSaveX(bool url, bool save)
     if(title.isEmpty())
         title = save ? i18n("Save") : i18n("Open");
 
-    QFileDialog dialog(nullptr, title, defaultPath.path());
+    DialogPool::Mode mode = save ? DialogPool::SaveMode : DialogPool::OpenMode;
+    QFileDialog *dialog = dialogs.take(mode);
+    dialog->setWindowTitle(title);
+    // Like the QFileDialog constructor, start in the directory of a file
+    QFileInfo start(defaultPath.path());
+    dialog->setDirectory(start.isDir() ? start.filePath() : start.path());
 
-    dialog.selectFile(defaultPath.fileName());
-    dialog.setNameFilters(filtersParsed);
-    dialog.setOption(QFileDialog::DontConfirmOverwrite, false);
-    dialog.setAcceptMode(save ? QFileDialog::AcceptSave : QFileDialog::AcceptOpen);
+    dialog->selectFile(defaultPath.fileName());
+    dialog->setNameFilters(filtersParsed);
+    dialog->setOption(QFileDialog::DontConfirmOverwrite, false);
+    dialog->setAcceptMode(save ? QFileDialog::AcceptSave : QFileDialog::AcceptOpen);
 
     if(save)
-        dialog.setFileMode((QFileDialog::AnyFile));
+        dialog->setFileMode((QFileDialog::AnyFile));
     else
-        dialog.setFileMode(multiple ? QFileDialog::ExistingFiles : QFileDialog::ExistingFile);
+        dialog->setFileMode(multiple ? QFileDialog::ExistingFiles : QFileDialog::ExistingFile);
 
-    if(selectFilter >= 0 && selectFilter >= dialog.nameFilters().size())
-        dialog.selectNameFilter(dialog.nameFilters().at(selectFilter));
+    if(selectFilter >= 0 && selectFilter >= dialog->nameFilters().size())
+        dialog->selectNameFilter(dialog->nameFilters().at(selectFilter));
 
     // If url == false only allow local files. Impossible to do with Qt < 5.6...
 #if(QT_VERSION >= QT_VERSION_CHECK(5, 6, 0))
     if(url == false)
-        dialog.setSupportedSchemes(QStringList(QStringLiteral("file")));
+        dialog->setSupportedSchemes(QStringList(QStringLiteral("file")));
 #endif
 
-    // Run dialog
-    if(dialog.exec() != QDialog::Accepted)
-        return false;
+    // Run dialog, the reply is sent once it's closed
+    Request *req = deferReply();
+    QString app = request->client->appname;
+    connect(dialog, &QDialog::finished, this, [this, dialog, mode, req, url, app](int code)
+    {
+        // Deleted later, its results stay until then
+        dialogs.release(mode, dialog);
+        if(code != QDialog::Accepted)
+            return finishRequest(req, false);
+        directories.used(app, dialog->directoryUrl());
 
-    int usedFilter = dialog.nameFilters().indexOf(dialog.selectedNameFilter());
+        int usedFilter = dialog->nameFilters().indexOf(dialog->selectedNameFilter());
 
-    if(url)
-    {
-        QList<QUrl> result = dialog.selectedUrls();
-        result.removeAll(QUrl());
-        if(!result.isEmpty())
+        if(url)
         {
-            outputLine(QStringLiteral("%0").arg(usedFilter));
-            for (const QUrl &url : result)
-                outputLine(url.url());
-            return true;
+            QList<QUrl> result = dialog->selectedUrls();
+            result.removeAll(QUrl());
+            if(!result.isEmpty())
+            {
+                req->reply.append(QStringLiteral("%0").arg(usedFilter));
+                for (const QUrl &url : result)
+                    req->reply.append(url.url());
+                return finishRequest(req, true);
+            }
         }
-    }
-    else
-    {
-        QStringList result = dialog.selectedFiles();
-        result.removeAll(QString());
-        if(!result.isEmpty())
+        else
         {
-            outputLine(QStringLiteral("%0").arg(usedFilter));
-            for (const QString &str : result)
-                outputLine(str);
-            return true;
+            QStringList result = dialog->selectedFiles();
+            result.removeAll(QString());
+            if(!result.isEmpty())
+            {
+                req->reply.append(QStringLiteral("%0").arg(usedFilter));
+                for (const QString &str : result)
+                    req->reply.append(str);
+                return finishRequest(req, true);
+            }
         }
-    }
-    return false;
+        finishRequest(req, false);
+    });
+    dialog->open();
+    return true;
 }
 
 bool Helper::handleGetDirectoryX(bool url)
@@ -448,25 +827,46 @@ bool Helper::handleGetDirectoryX(bool url)
     if(!allArgumentsUsed())
         return false;
 
-    if(url)
+    QFileDialog *dialog = dialogs.take(DialogPool::DirectoryMode);
+    dialog->setWindowTitle(title);
+    dialog->setDirectory(startDir);
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 6, 0))
+    if(url == false)
+        dialog->setSupportedSchemes(QStringList(QStringLiteral("file")));
+#endif
+
+    Request *req = deferReply();
+    QString app = request->client->appname;
+    connect(dialog, &QDialog::finished, this, [this, dialog, req, url, app](int code)
     {
-        QUrl result = QFileDialog::getExistingDirectoryUrl(nullptr, title, startDir);
-        if(result.isValid())
+        dialogs.release(DialogPool::DirectoryMode, dialog);
+        if(code != QDialog::Accepted)
+            return finishRequest(req, false);
+        // The next directory is likely chosen next to this one
+        directories.used(app, dialog->directoryUrl());
+
+        if(url)
         {
-            outputLine(result.url());
-            return true;
+            QUrl result = dialog->selectedUrls().value(0);
+            if(result.isValid())
+            {
+                req->reply.append(result.url());
+                return finishRequest(req, true);
+            }
         }
-    }
-    else
-    {
-        QString result = QFileDialog::getExistingDirectory(nullptr, title, startDir);
-        if(!result.isEmpty())
+        else
         {
-            outputLine(result);
-            return true;
+            QString result = dialog->selectedFiles().value(0);
+            if(!result.isEmpty())
+            {
+                req->reply.append(result);
+                return finishRequest(req, true);
+            }
         }
-    }
-    return false;
+        finishRequest(req, false);
+    });
+    dialog->open();
+    return true;
 }
 
 bool Helper::handleOpen()
@@ -480,43 +880,105 @@ bool Helper::handleOpen()
     if(!allArgumentsUsed())
         return false;
     // try to handle the case when the server has broken mimetypes and e.g. claims something is application/octet-stream
-    QMimeType mimeType = QMimeDatabase().mimeTypeForName(mime);
-    if(!mime.isEmpty() && mimeType.isValid() && KMimeTypeTrader::self()->preferredService(mimeType.name()))
+    if(!mime.isEmpty() && !handlers.mimeInfoForType(mime).service.isEmpty())
     {
         return KRun::runUrl(url, mime, NULL, KRun::RunFlags()); // TODO parent
     }
-    else
+    // KRun would find out the type of local files through KIO, which is much slower
+    if(url.isLocalFile() && QFileInfo(url.toLocalFile()).isFile())
     {
-        (void) new KRun(url, NULL); // TODO parent
-        //    QObject::connect(run, SIGNAL(finished()), &app, SLOT(openDone()));
-        //    QObject::connect(run, SIGNAL(error()), &app, SLOT(openDone()));
-        return true; // TODO check for errors?
+        HandlerCache::MimeInfo info = handlers.mimeInfoForFile(url.toLocalFile());
+        if(!info.service.isEmpty())
+            return KRun::runUrl(url, info.name, NULL, KRun::RunFlags()); // TODO parent
     }
+    // Without a known application, KRun asks the user
+    return launch(url);
 }
 
 bool Helper::handleReveal()
 {
     if(!readArguments(1))
         return false;
-    QString path = getArgument();
+    QStringList paths = getAllArguments();
     if(!allArgumentsUsed())
         return false;
-    const KService::List apps = KMimeTypeTrader::self()->query("inode/directory", "Application");
-    if(apps.size() != 0)
+
+    // Others don't wait for the result
+    Request *req = request->client->pipelined ? deferReply() : nullptr;
+    LaunchQueue::Callback done = [this, req](bool ok)
+    {
+        if(req)
+            finishRequest(req, ok);
+    };
+
+    // One call for all paths, handled by a running file manager if there is one
+    QStringList uris;
+    for(const QString &path : paths)
+        uris.append(QUrl::fromLocalFile(path).toString());
+    QDBusMessage call = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.FileManager1"),
+                                                       QStringLiteral("/org/freedesktop/FileManager1"),
+                                                       QStringLiteral("org.freedesktop.FileManager1"),
+                                                       QStringLiteral("ShowItems"));
+    call << uris << QString();
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(call), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, paths, done]()
+    {
+        watcher->deleteLater();
+        if(!watcher->isError())
+            return done(true);
+#ifdef DEBUG_KDE
+        std::cerr << "ShowItems failed: " << watcher->error().message().toStdString() << std::endl;
+#endif
+        revealWithoutDBus(paths, done);
+    });
+    return true;
+}
+
+void Helper::revealWithoutDBus(const QStringList& paths, const LaunchQueue::Callback& done)
+{
+    // done is called once, when all are done
+    struct Pending
+    {
+        int count;
+        bool ok;
+    };
+    std::shared_ptr<Pending> pending(new Pending{ paths.size(), true });
+    LaunchQueue::Callback finish = [pending, done](bool ok)
+    {
+        pending->ok = pending->ok && ok;
+        if(--pending->count == 0)
+            done(pending->ok);
+    };
+
+    QString command = executables.fileManager();
+    for(const QString &path : paths)
     {
-        QString command = apps.at(0)->exec().split(" ").first(); // only the actual command
         if(command == "dolphin" || command == "konqueror")
         {
-            command = QStandardPaths::findExecutable(command);
-            if(command.isEmpty())
-                return false;
-            return KProcess::startDetached(command, QStringList() << "--select" << path);
+            QString executable = executables.find(command);
+            finish(!executable.isEmpty() && KProcess::startDetached(executable, QStringList() << "--select" << path));
+            continue;
         }
+        QFileInfo info(path);
+        QString dir = info.dir().path();
+        launches.open(QUrl::fromLocalFile(dir), finish);
     }
-    QFileInfo info(path);
-    QString dir = info.dir().path();
-    (void) new KRun(QUrl::fromLocalFile(dir), NULL); // TODO parent
-    return true; // TODO check for errors?
+}
+
+bool Helper::launch(const QUrl& url)
+{
+    // Others don't wait for the result
+    if(!request->client->pipelined)
+    {
+        launches.open(url, LaunchQueue::Callback());
+        return true;
+    }
+    Request *req = deferReply();
+    launches.open(url, [this, req](bool ok)
+    {
+        finishRequest(req, ok);
+    });
+    return true;
 }
 
 bool Helper::handleRun()
@@ -527,7 +989,19 @@ bool Helper::handleRun()
     QString arg = getArgument();
     if(!allArgumentsUsed())
         return false;
-    return KRun::runCommand(KShell::quoteArg(app) + " " + KShell::quoteArg(arg), NULL); // TODO parent, ASN
+    return runProgram(QStringList() << app << arg);
+}
+
+bool Helper::runProgram(QStringList argv)
+{
+    QString executable = executables.find(argv.first());
+    if(executable.isEmpty())
+    {
+        std::cerr << "Cannot find " << argv.first().toStdString() << std::endl;
+        return false;
+    }
+    argv[0] = executable;
+    return spawner.spawn(argv);
 }
 
 bool Helper::handleGetDefaultFeedReader()
@@ -535,7 +1009,7 @@ bool Helper::handleGetDefaultFeedReader()
     if(!readArguments(0))
         return false;
     // firefox wants the full path
-    QString reader = QStandardPaths::findExecutable("akregator"); // TODO there is no KDE setting for this
+    QString reader = executables.find("akregator"); // TODO there is no KDE setting for this
     if(!reader.isEmpty())
     {
         outputLine(reader);
@@ -548,24 +1022,14 @@ bool Helper::handleOpenMail()
 {
     if(!readArguments(0))
         return false;
-    // this is based on ktoolinvocation_x11.cpp, there is no API for this
-    KConfig config("emaildefaults");
-    QString groupname = KConfigGroup(&config, "Defaults").readEntry("Profile", "Default");
-    KConfigGroup group(&config, QString("PROFILE_%1").arg(groupname));
-    QString command = group.readPathEntry("EmailClient", QString());
-    if(command.isEmpty())
-        command = "kmail";
-    if(group.readEntry("TerminalClient", false))
-    {
-        QString terminal = KConfigGroup(KSharedConfig::openConfig(), "General").readPathEntry("TerminalApplication", "konsole");
-        command = terminal + " -e " + command;
-    }
-    KService::Ptr mail = KService::serviceByDesktopName(command.split(" ").first());
-    if(mail)
-    {
-        return KRun::runService(*mail, QList<QUrl>(), NULL); // TODO parent
-    }
-    return false;
+    ConfigWatcher::SnapshotPtr settings = config.snapshot();
+    // Placeholders for the message would follow, only the actual command
+    QString mailer = KShell::splitArgs(settings->mail_client).value(0, "kmail");
+    QStringList argv;
+    if(settings->mail_in_terminal)
+        argv << KShell::splitArgs(settings->terminal) << "-e";
+    argv << mailer;
+    return runProgram(argv);
 }
 
 bool Helper::handleOpenNews()
@@ -575,8 +1039,9 @@ bool Helper::handleOpenNews()
     KService::Ptr news = KService::serviceByDesktopName("knode"); // TODO there is no KDE setting for this
     if(news)
     {
-        //KApplication::updateUserTimestamp(0); // TODO
-        return KRun::runService(*news, QList<QUrl>(), NULL); // TODO parent
+        QStringList argv = KIO::DesktopExecParser(*news, QList<QUrl>()).resultingArguments();
+        if(!argv.isEmpty())
+            return runProgram(argv);
     }
     return false;
 }
@@ -585,8 +1050,7 @@ bool Helper::handleIsDefaultBrowser()
 {
     if(!readArguments(0))
         return false;
-    QString browser = KConfigGroup(KSharedConfig::openConfig("kdeglobals"), "General")
-            .readEntry("BrowserApplication");
+    QString browser = config.snapshot()->browser;
     return browser == "MozillaFirefox" || browser == "MozillaFirefox.desktop"
             || browser == "!firefox" || browser == "!/usr/bin/firefox"
             || browser == "firefox" || browser == "firefox.desktop";
@@ -599,8 +1063,7 @@ bool Helper::handleSetDefaultBrowser()
     bool alltypes = (getArgument() == "ALLTYPES");
     if(!allArgumentsUsed())
         return false;
-    KConfigGroup(KSharedConfig::openConfig("kdeglobals"), "General")
-            .writeEntry("BrowserApplication", "firefox");
+    config.setDefaultBrowser("firefox");
     if(alltypes)
     {
         // TODO there is no API for this and it is a bit complex
@@ -615,72 +1078,19 @@ bool Helper::handleDownloadFinished()
     QString download = getArgument();
     if(!allArgumentsUsed())
         return false;
-    // TODO cheat a bit due to i18n freeze - the strings are in the .notifyrc file,
-    // taken from KGet, but the notification itself needs the text too.
-    // So create it from there.
-    KConfig cfg("kmozillahelper.notifyrc", KConfig::FullConfig, QStandardPaths::AppDataLocation);
-    QString message = KConfigGroup(&cfg, "Event/downloadfinished").readEntry("Comment");
-    KNotification::event("downloadfinished", download + " : " + message);
+    downloads.downloadFinished(download);
     return true;
 }
 
-QString Helper::getAppForProtocol(const QString& protocol)
-{
-    /* Inspired by kio's krun.cpp */
-    const KService::Ptr service = KMimeTypeTrader::self()->preferredService(QLatin1String("x-scheme-handler/") + protocol);
-    if (service)
-        return service->name();
-
-    /* Some KDE services (e.g. vnc) also support application associations.
-     * Those are known as "Helper Protocols".
-     * However, those aren't also registered using fake mime types and there
-     * is no link to a .desktop file...
-     * So we need to query for the service to use and then find the .desktop
-     * file for that application by comparing the Exec values. */
-
-    if(!KProtocolInfo::isHelperProtocol(protocol))
-        return {};
-
-    QString exec = KProtocolInfo::exec(protocol);
-
-    if(exec.isEmpty())
-        return {};
-
-    if(exec.contains(' '))
-        exec = exec.split(' ').first(); // first part of command
-
-    if(KService::Ptr service = KService::serviceByDesktopName(exec))
-        return service->name();
-
-    QString servicename;
-    foreach(KService::Ptr service, KService::allServices())
-    {
-        QString exec2 = service->exec();
-        if(exec2.contains(' '))
-            exec2 = exec2.split(' ').first(); // first part of command
-        if(exec == exec2)
-        {
-            servicename = service->name();
-            break;
-        }
-    }
-
-    if(servicename.isEmpty() && exec == "kmailservice") // kmailto is handled internally by kmailservice
-        servicename = i18n("KDE");
-
-    return servicename;
-}
-
-QString Helper::readLine()
+bool Helper::handleStats()
 {
-    std::string line;
-    if(!std::getline(std::cin, line))
-        return {};
-
-    QString qline = QString::fromStdString(line);
-    qline.replace("\\n", "\n");
-    qline.replace("\\" "\\", "\\");
-    return qline;
+    if(!readArguments(0))
+        return false;
+    if(!allArgumentsUsed())
+        return false;
+    for(const QString &line : stats.report())
+        outputLine(line);
+    return true;
 }
 
 /* Qt just uses the QWidget* parent as transient parent for native
@@ -704,40 +1114,19 @@ bool Helper::eventFilter(QObject *obj, QEvent *ev)
     return false;
 }
 
-void Helper::outputLine(QString line, bool escape)
+void Helper::outputLine(const QString& line)
 {
-    if(escape)
-    {
-        line.replace("\\",  "\\" "\\");
-        line.replace("\n", "\\n");
-    }
-    std::cout << line.toStdString() << std::endl;
-#ifdef DEBUG_KDE
-    std::cerr << "OUTPUT: " << line.toStdString() << std::endl;
-#endif
+    request->reply.append(line);
 }
 
 bool Helper::readArguments(int mincount)
 {
-    assert(arguments.isEmpty());
-    for(;;)
-    {
-        QString line = readLine();
-        if(!std::cin.good())
-        {
-            arguments.clear();
-            return false;
-        }
-        if(line == "\\E")
-        {
-            arguments_read = true;
-            if(arguments.count() >= mincount)
-                return true;
-            std::cerr << "Not enough arguments for KDE helper." << std::endl;
-            return false;
-        }
-        arguments.append(line);
-    }
+    // The arguments arrived together with the command
+    arguments_read = true;
+    if(arguments.count() >= mincount)
+        return true;
+    std::cerr << "Not enough arguments for KDE helper." << std::endl;
+    return false;
 }
 
 QString Helper::getArgument()
@@ -746,6 +1135,13 @@ QString Helper::getArgument()
     return arguments.takeFirst();
 }
 
+QStringList Helper::getAllArguments()
+{
+    QStringList ret;
+    ret.swap(arguments);
+    return ret;
+}
+
 bool Helper::isArgument(const QString& argument)
 {
     if(!arguments.isEmpty() && arguments.first() == argument)
@@ -24,52 +24,125 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef MAIN_H
 #define MAIN_H
 
-#include <QtCore/QMimeType>
-#include <QtCore/QSocketNotifier>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtCore/QTimer>
+
+#include "configwatcher.h"
+#include "daemon.h"
+#include "dialogpool.h"
+#include "dirprefetcher.h"
+#include "downloadnotifier.h"
+#include "executablecache.h"
+#include "handlercache.h"
+#include "launchqueue.h"
+#include "prewarmer.h"
+#include "proxycache.h"
+#include "spawner.h"
+#include "stats.h"
+#include "trace.h"
+#include "transport.h"
 
 class Helper : public QObject
 {
     Q_OBJECT
 public:
     Helper();
+    void prewarm();
+    // Serves the browser on the other side of the given fds
+    void addClient(int infd, int outfd, const QString& appname);
+    // Serves everything connecting to server and keeps running without clients
+    void serve(DaemonServer *server);
+    // Records commands and replies into the given file
+    bool startTrace(const QString& path);
 private:
+    // A browser process, there is more than one in shared mode
+    struct Client : public QObject
+    {
+        Client(int infd, int outfd, const QString& appname);
+        Transport transport;
+        QString appname; // shown on dialogs
+        quint32 id = 0; // in traces
+        bool pipelined = false;
+        bool binary_pending = false;
+        bool events = false; // wants unsolicited events
+    };
+    struct Request
+    {
+        QPointer<Client> client; // gone if it disconnected before the reply
+        quint32 client_id = 0;
+        QString tag; // request ID in pipelined mode, empty otherwise
+        QString command;
+        QElapsedTimer timer; // for the statistics
+        QStringList reply; // unescaped reply lines
+        bool deferred = false; // reply sent later by finishRequest()
+    };
     bool handleCheck();
     bool handleGetProxy();
     bool handleHandlerExists();
     bool handleGetFromExtension();
     bool handleGetFromType();
+    bool handleHandlersExist();
+    bool handleGetFromExtensions();
+    bool handleGetFromTypes();
+    bool handleGetHandlerSnapshot();
     bool handleGetAppDescForScheme();
     bool handleAppsDialog();
     bool handleGetOpenOrSaveX(bool url, bool save);
     bool handleGetDirectoryX(bool url);
     bool handleOpen();
     bool handleReveal();
+    void revealWithoutDBus(const QStringList& paths, const LaunchQueue::Callback& done);
+    bool launch(const QUrl& url);
     bool handleRun();
+    bool runProgram(QStringList argv);
     bool handleGetDefaultFeedReader();
     bool handleOpenMail();
     bool handleOpenNews();
     bool handleIsDefaultBrowser();
     bool handleSetDefaultBrowser();
     bool handleDownloadFinished();
+    bool handleStats();
     QStringList convertToNameFilters(const QString &input);
-    bool writeMimeInfo(QMimeType mime);
-    QString getAppForProtocol(const QString& protocol);
+    bool writeMimeInfo(const HandlerCache::MimeInfo& mime);
+    void writeMimeItem(const HandlerCache::MimeInfo& mime);
     bool readArguments(int mincount);
     QString getArgument();
+    QStringList getAllArguments();
     bool isArgument(const QString& name); // also discards the line with it
     bool allArgumentsUsed();
     long getArgumentParent();
-    void outputLine(QString line, bool escape = true);
-    QString readLine();
+    void outputLine(const QString& line);
+    Request *deferReply();
+    void finishRequest(Request *req, bool status);
 protected:
     virtual bool eventFilter(QObject *obj, QEvent *ev) override;
-private slots:
-    void readCommand();
 private:
-    QSocketNotifier notifier;
+    void readCommand(Client *client);
+    void runCommand(Client *client, const QString& command, const QString& tag);
+    void removeClient(Client *client);
+    void broadcastEvent(const QString& event);
+private:
+    QList<Client*> clients;
+    quint32 last_client_id;
+    bool shared; // a daemon still accepting clients, not exiting without them
+    QTimer idle_timer; // exits the daemon once nobody used it for a while
+    ConfigWatcher config;
+    DialogPool dialogs;
+    DirPrefetcher directories;
+    DownloadNotifier downloads;
+    ExecutableCache executables;
+    HandlerCache handlers;
+    ProxyCache proxies;
+    Spawner spawner;
+    Prewarmer prewarmer;
+    LaunchQueue launches;
+    Stats stats;
+    TraceRecorder trace;
     QStringList arguments;
     bool arguments_read;
     long wid;
+    Request *request;
 };
 
 #endif
@@ -0,0 +1,321 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "pacengine.h"
+
+#include <iostream>
+
+#include <QtCore/QFile>
+#include <QtNetwork/QHostInfo>
+#include <QtNetwork/QNetworkInterface>
+
+// How long FindProxyForURL results are used for the same URL, in ms
+static const qint64 RESULT_TTL = 5 * 60 * 1000;
+static const int MAX_RESULTS = 1024;
+
+// The standard PAC helper functions, modeled after Mozilla's implementation
+static const char pac_utils[] = R"JS(
+function dnsResolve(host) {
+    var ip = _pac.dnsResolve(host);
+    return ip ? ip : null;
+}
+
+function myIpAddress() {
+    return _pac.myIpAddress();
+}
+
+function dnsDomainIs(host, domain) {
+    return (host.length >= domain.length &&
+            host.substring(host.length - domain.length) == domain);
+}
+
+function dnsDomainLevels(host) {
+    return host.split('.').length - 1;
+}
+
+function isPlainHostName(host) {
+    return host.indexOf('.') == -1;
+}
+
+function isResolvable(host) {
+    return dnsResolve(host) != null;
+}
+
+function localHostOrDomainIs(host, hostdom) {
+    return (host == hostdom) || (hostdom.lastIndexOf(host + '.', 0) == 0);
+}
+
+function convert_addr(ipchars) {
+    var bytes = ipchars.split('.');
+    return ((bytes[0] & 0xff) << 24) | ((bytes[1] & 0xff) << 16) |
+           ((bytes[2] & 0xff) << 8) | (bytes[3] & 0xff);
+}
+
+function isInNet(ipaddr, pattern, maskstr) {
+    if (!/^\d+\.\d+\.\d+\.\d+$/.test(ipaddr)) {
+        ipaddr = dnsResolve(ipaddr);
+        if (ipaddr == null)
+            return false;
+    }
+    var host = convert_addr(ipaddr);
+    var pat = convert_addr(pattern);
+    var mask = convert_addr(maskstr);
+    return (host & mask) == (pat & mask);
+}
+
+function shExpMatch(url, pattern) {
+    pattern = pattern.replace(/([\\^$+.()|{}\[\]])/g, '\\$1');
+    pattern = pattern.replace(/\*/g, '.*');
+    pattern = pattern.replace(/\?/g, '.');
+    return new RegExp('^' + pattern + '$').test(url);
+}
+
+var wdays = {SUN: 0, MON: 1, TUE: 2, WED: 3, THU: 4, FRI: 5, SAT: 6};
+var months = {JAN: 0, FEB: 1, MAR: 2, APR: 3, MAY: 4, JUN: 5,
+              JUL: 6, AUG: 7, SEP: 8, OCT: 9, NOV: 10, DEC: 11};
+
+function weekdayRange() {
+    function getDay(weekday) {
+        return (weekday in wdays) ? wdays[weekday] : -1;
+    }
+    var date = new Date();
+    var argc = arguments.length;
+    var wday;
+    if (argc < 1)
+        return false;
+    if (arguments[argc - 1] == 'GMT') {
+        argc--;
+        wday = date.getUTCDay();
+    } else {
+        wday = date.getDay();
+    }
+    var wd1 = getDay(arguments[0]);
+    var wd2 = (argc == 2) ? getDay(arguments[1]) : wd1;
+    if (wd1 == -1 || wd2 == -1)
+        return false;
+    if (wd1 <= wd2)
+        return wd1 <= wday && wday <= wd2;
+    return wd2 >= wday || wday >= wd1;
+}
+
+function toLocalFields(date) {
+    var tmp = new Date(date.getTime());
+    tmp.setFullYear(date.getUTCFullYear(), date.getUTCMonth(), date.getUTCDate());
+    tmp.setHours(date.getUTCHours(), date.getUTCMinutes(), date.getUTCSeconds());
+    return tmp;
+}
+
+function dateRange() {
+    function getMonth(name) {
+        return (name in months) ? months[name] : -1;
+    }
+    var date = new Date();
+    var argc = arguments.length;
+    if (argc < 1)
+        return false;
+    var isGMT = (arguments[argc - 1] == 'GMT');
+    if (isGMT)
+        argc--;
+    if (argc == 1) {
+        var tmp = parseInt(arguments[0]);
+        if (isNaN(tmp))
+            return (isGMT ? date.getUTCMonth() : date.getMonth()) == getMonth(arguments[0]);
+        if (tmp < 32)
+            return (isGMT ? date.getUTCDate() : date.getDate()) == tmp;
+        return (isGMT ? date.getUTCFullYear() : date.getFullYear()) == tmp;
+    }
+    var year = date.getFullYear();
+    var date1 = new Date(year, 0, 1, 0, 0, 0);
+    var date2 = new Date(year, 11, 31, 23, 59, 59);
+    var adjustMonth = false;
+    for (var i = 0; i < argc; i++) {
+        var target = (i < (argc >> 1)) ? date1 : date2;
+        var value = parseInt(arguments[i]);
+        if (isNaN(value)) {
+            target.setMonth(getMonth(arguments[i]));
+        } else if (value < 32) {
+            adjustMonth = (argc <= 2);
+            target.setDate(value);
+        } else {
+            target.setFullYear(value);
+        }
+    }
+    if (adjustMonth) {
+        date1.setMonth(date.getMonth());
+        date2.setMonth(date.getMonth());
+    }
+    if (isGMT)
+        date = toLocalFields(date);
+    return (date1 <= date2) ? (date1 <= date && date <= date2)
+                            : (date2 >= date || date >= date1);
+}
+
+function timeRange() {
+    var argc = arguments.length;
+    var date = new Date();
+    var isGMT = false;
+    if (argc < 1)
+        return false;
+    if (arguments[argc - 1] == 'GMT') {
+        isGMT = true;
+        argc--;
+    }
+    var hour = isGMT ? date.getUTCHours() : date.getHours();
+    if (argc == 1)
+        return hour == arguments[0];
+    if (argc == 2)
+        return arguments[0] <= hour && hour <= arguments[1];
+    if (argc != 4 && argc != 6)
+        return false;
+    var middle = argc >> 1;
+    var date1 = new Date();
+    var date2 = new Date();
+    date1.setHours(arguments[0], arguments[1], argc == 6 ? arguments[2] : 0);
+    date2.setHours(arguments[middle], arguments[middle + 1], argc == 6 ? arguments[5] : 59);
+    if (isGMT)
+        date = toLocalFields(date);
+    return (date1 <= date2) ? (date1 <= date && date <= date2)
+                            : (date2 >= date || date >= date1);
+}
+)JS";
+
+PacFunctions::PacFunctions(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QString PacFunctions::dnsResolve(const QString& host)
+{
+    // PAC scripts are synchronous, so this has to block
+    const QList<QHostAddress> addresses = QHostInfo::fromName(host).addresses();
+    for(const QHostAddress &address : addresses)
+    {
+        if(address.protocol() == QAbstractSocket::IPv4Protocol)
+            return address.toString();
+    }
+    return {};
+}
+
+QString PacFunctions::myIpAddress()
+{
+    const QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
+    for(const QHostAddress &address : addresses)
+    {
+        if(!address.isLoopback() && address.protocol() == QAbstractSocket::IPv4Protocol)
+            return address.toString();
+    }
+    return QStringLiteral("127.0.0.1");
+}
+
+PacEngine::PacEngine(QObject *parent)
+    : QObject(parent)
+    , engine(nullptr)
+    , stale(false)
+{
+    clock.start();
+    connect(&watch, &KDirWatch::dirty, this, &PacEngine::scriptChanged);
+    connect(&watch, &KDirWatch::created, this, &PacEngine::scriptChanged);
+    connect(&watch, &KDirWatch::deleted, this, &PacEngine::scriptChanged);
+}
+
+void PacEngine::scriptChanged()
+{
+    stale = true;
+}
+
+void PacEngine::unload()
+{
+    results.clear();
+    find_proxy = QJSValue();
+    delete engine;
+    engine = nullptr;
+}
+
+bool PacEngine::load(const QUrl& url)
+{
+    if(url == script_url && !stale)
+        return engine != nullptr;
+
+    if(url != script_url)
+    {
+        if(script_url.isLocalFile())
+            watch.removeFile(script_url.toLocalFile());
+        script_url = url;
+        if(url.isLocalFile())
+            watch.addFile(url.toLocalFile());
+    }
+    unload();
+    stale = false;
+
+    if(!url.isLocalFile())
+        return false;
+    QFile file(url.toLocalFile());
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        std::cerr << "Cannot read PAC script " << url.toLocalFile().toStdString() << std::endl;
+        return false;
+    }
+
+    engine = new QJSEngine(this);
+    // Parented, so it's not owned by the JS engine
+    engine->globalObject().setProperty(QStringLiteral("_pac"), engine->newQObject(new PacFunctions(engine)));
+    engine->evaluate(QString::fromLatin1(pac_utils));
+    QJSValue ret = engine->evaluate(QString::fromUtf8(file.readAll()), url.toString());
+    find_proxy = engine->globalObject().property(QStringLiteral("FindProxyForURL"));
+    if(ret.isError() || !find_proxy.isCallable())
+    {
+        std::cerr << "Invalid PAC script " << url.toLocalFile().toStdString() << ": "
+                  << ret.toString().toStdString() << std::endl;
+        unload();
+        return false;
+    }
+    return true;
+}
+
+QString PacEngine::findProxy(const QUrl& url)
+{
+    // Per URL, scripts may look at the scheme or the path, not only the host
+    const QString spec = url.toString();
+    const qint64 now = clock.elapsed();
+    auto it = results.constFind(spec);
+    if(it != results.constEnd() && it->expires > now)
+    {
+        ++stats.hits;
+        return it->proxies;
+    }
+    ++stats.misses;
+
+    QJSValue ret = find_proxy.call(QJSValueList() << spec << url.host());
+    Result result;
+    result.proxies = QStringLiteral("DIRECT");
+    if(ret.isError())
+        std::cerr << "Error in FindProxyForURL: " << ret.toString().toStdString() << std::endl;
+    else if(ret.isString() && !ret.toString().trimmed().isEmpty())
+        result.proxies = ret.toString().trimmed();
+    result.expires = now + RESULT_TTL;
+
+    if(results.size() >= MAX_RESULTS)
+        results.clear();
+    results.insert(spec, result);
+    return result.proxies;
+}
@@ -0,0 +1,80 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef PACENGINE_H
+#define PACENGINE_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+#include <QtQml/QJSEngine>
+
+#include <KCoreAddons/KDirWatch>
+
+#include "stats.h"
+
+/* Native parts of the PAC helper functions, the rest is implemented in JS. */
+class PacFunctions : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PacFunctions(QObject *parent = nullptr);
+    Q_INVOKABLE QString dnsResolve(const QString& host);
+    Q_INVOKABLE QString myIpAddress();
+};
+
+/* Evaluates proxy auto-config scripts. The script is compiled once and only
+ * reloaded when the file changes, results of FindProxyForURL are remembered
+ * per URL for a while. Only local scripts are supported, for anything else
+ * the caller has to ask KIO. */
+class PacEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PacEngine(QObject *parent = nullptr);
+    // Returns whether the script at url is (now) loaded and usable
+    bool load(const QUrl& url);
+    // The PAC result for url, e.g. "PROXY host:port; DIRECT"
+    QString findProxy(const QUrl& url);
+    const CacheStats *cacheStats() const { return &stats; }
+private slots:
+    void scriptChanged();
+private:
+    struct Result
+    {
+        QString proxies;
+        qint64 expires;
+    };
+    void unload();
+    QJSEngine *engine;
+    QJSValue find_proxy;
+    QUrl script_url;
+    bool stale;
+    QHash<QString, Result> results;
+    QElapsedTimer clock;
+    KDirWatch watch;
+    CacheStats stats;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "prewarmer.h"
+
+#include <QtGui/QIcon>
+
+#include "dialogpool.h"
+#include "handlercache.h"
+
+// in ms, how long to wait after startup and after a command
+static const int START_DELAY = 50;
+static const int QUIET_DELAY = 250;
+
+Prewarmer::Prewarmer(HandlerCache &handlers, DialogPool &dialogs, QObject *parent)
+    : QObject(parent)
+{
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, &Prewarmer::runStage);
+
+    // Cheapest and most likely needed first
+    stages << [&handlers]()
+    {
+        // Opens the shared MIME database and KSycoca and caches the usual suspects
+        for(const char *ext : {"html", "pdf", "txt", "zip", "png", "jpg"})
+            handlers.mimeInfoForExtension(QString::fromLatin1(ext));
+        for(const char *type : {"text/html", "application/xhtml+xml", "application/pdf", "application/octet-stream"})
+            handlers.mimeInfoForType(QString::fromLatin1(type));
+    };
+    stages << [&handlers]()
+    {
+        for(const char *scheme : {"mailto", "news", "irc", "webcal"})
+            handlers.schemeInfo(QString::fromLatin1(scheme));
+    };
+    stages << []()
+    {
+        // Loads the icon theme index and the icons every dialog shows
+        for(const char *name : {"folder", "document-open", "document-save", "go-up", "view-refresh"})
+            QIcon::fromTheme(QString::fromLatin1(name)).pixmap(22, 22);
+    };
+    // Makes the platform theme load its file dialog implementation and KIO,
+    // then keeps one dialog per mode ready
+    for(DialogPool::Mode mode : {DialogPool::OpenMode, DialogPool::SaveMode, DialogPool::DirectoryMode})
+    {
+        stages << [&dialogs, mode]()
+        {
+            dialogs.prewarm(mode);
+        };
+    }
+}
+
+void Prewarmer::start()
+{
+    timer.start(START_DELAY);
+}
+
+void Prewarmer::postpone()
+{
+    if(timer.isActive())
+        timer.start(QUIET_DELAY);
+}
+
+void Prewarmer::runStage()
+{
+    if(stages.isEmpty())
+        return;
+    stages.takeFirst()();
+    // Give pending commands a chance before the next one
+    if(!stages.isEmpty())
+        timer.start(0);
+}
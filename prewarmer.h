@@ -0,0 +1,55 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef PREWARMER_H
+#define PREWARMER_H
+
+#include <functional>
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+class DialogPool;
+class HandlerCache;
+
+/* Loads everything the first commands would otherwise have to wait for
+ * (MIME database, KSycoca, icon theme, file dialogs) in small stages
+ * while the helper is idle. Commands always take precedence: after each one,
+ * the next stage only runs once nothing happened for a while. */
+class Prewarmer : public QObject
+{
+    Q_OBJECT
+public:
+    Prewarmer(HandlerCache &handlers, DialogPool &dialogs, QObject *parent = nullptr);
+    void start();
+    // A command arrived, wait until things are quiet again
+    void postpone();
+private slots:
+    void runStage();
+private:
+    QList<std::function<void()> > stages;
+    QTimer timer;
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "proxycache.h"
+
+#include <QtCore/QStandardPaths>
+
+#include <KIOCore/KProtocolManager>
+
+// Firefox asks for every single host, don't let that grow forever
+static const int MAX_RESULTS = 1024;
+
+ProxyCache::ProxyCache(QObject *parent)
+    : QObject(parent)
+    , local(false)
+    , compiled(false)
+{
+    QString config = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+            + QStringLiteral("/kioslaverc");
+    watch.addFile(config);
+    connect(&watch, &KDirWatch::dirty, this, &ProxyCache::configChanged);
+    connect(&watch, &KDirWatch::created, this, &ProxyCache::configChanged);
+    connect(&watch, &KDirWatch::deleted, this, &ProxyCache::configChanged);
+}
+
+void ProxyCache::configChanged()
+{
+    KProtocolManager::reparseConfiguration();
+    results.clear();
+    trie.clear();
+    subnets.clear();
+    local = false;
+    compiled = false;
+    emit changed();
+}
+
+QString ProxyCache::proxyFor(const QUrl& url)
+{
+    // PAC results expire on their own, so PacEngine remembers them itself
+    KProtocolManager::ProxyType type = KProtocolManager::proxyType();
+    if(type == KProtocolManager::PACProxy
+       && pac.load(QUrl::fromUserInput(KProtocolManager::proxyConfigScript())))
+        return pac.findProxy(url);
+    // A remote script can change without kioslaverc changing, don't keep
+    // its answers forever; KIO's proxy scout caches them for a while already
+    if(type == KProtocolManager::PACProxy || type == KProtocolManager::WPADProxy)
+        return resolve(url);
+
+    QString key = url.scheme() + QStringLiteral("://") + url.host() + QLatin1Char(':') + QString::number(url.port());
+    auto it = results.constFind(key);
+    if(it != results.constEnd())
+    {
+        ++stats.hits;
+        return *it;
+    }
+    ++stats.misses;
+
+    if(results.size() >= MAX_RESULTS)
+        results.clear();
+    QString result = resolve(url);
+    results.insert(key, result);
+    return result;
+}
+
+QString ProxyCache::resolve(const QUrl& url)
+{
+    QStringList proxies;
+    switch(KProtocolManager::proxyType())
+    {
+    case KProtocolManager::NoProxy:
+        break;
+    case KProtocolManager::ManualProxy:
+    {
+        if(!compiled)
+            compileNoProxy();
+        // The trie can't tell whether a host name is in a subnet, let KIO resolve it
+        if(!subnets.isEmpty() && QHostAddress(url.host()).isNull())
+        {
+            proxies = KProtocolManager::proxiesForUrl(url);
+            break;
+        }
+        if(ignoreProxyFor(url))
+            break;
+        // Same as KProtocolManager::proxiesForUrl, with SOCKS as alternative
+        QString proxy = KProtocolManager::proxyFor(url.scheme());
+        if(!proxy.isEmpty())
+            proxies << proxy;
+        proxy = KProtocolManager::proxyFor(QStringLiteral("socks"));
+        if(!proxy.isEmpty())
+        {
+            int index = proxy.indexOf(QLatin1String("://"));
+            proxies << QStringLiteral("socks://") + proxy.mid(index == -1 ? 0 : index + 3);
+        }
+        break;
+    }
+    default: // remote PAC, WPAD (both not cached) and environment variables
+        proxies = KProtocolManager::proxiesForUrl(url);
+        break;
+    }
+
+    QStringList result;
+    for(const QString &proxy : proxies)
+    {
+        QString entry = toPacResult(proxy);
+        if(!entry.isEmpty() && !result.contains(entry))
+            result << entry;
+    }
+    if(result.isEmpty())
+        return QStringLiteral("DIRECT");
+    return result.join(QStringLiteral("; "));
+}
+
+QString ProxyCache::toPacResult(const QString& proxy)
+{
+    if(proxy == QLatin1String("DIRECT"))
+        return proxy;
+    QUrl proxyurl = QUrl::fromUserInput(proxy);
+    if(!proxyurl.isValid() || proxyurl.host().isEmpty())
+        return {};
+
+    // firefox wants this format
+    QString scheme = proxyurl.scheme().toLower();
+    QString type;
+    int port;
+    if(scheme == QLatin1String("https"))
+    {
+        type = QStringLiteral("HTTPS");
+        port = proxyurl.port(443);
+    }
+    else if(scheme == QLatin1String("socks4"))
+    {
+        type = QStringLiteral("SOCKS");
+        port = proxyurl.port(1080);
+    }
+    else if(scheme.startsWith(QLatin1String("socks"))) // KIO speaks SOCKS5
+    {
+        type = QStringLiteral("SOCKS5");
+        port = proxyurl.port(1080);
+    }
+    else
+    {
+        type = QStringLiteral("PROXY");
+        port = proxyurl.port(80);
+    }
+    return type + QLatin1Char(' ') + proxyurl.host() + QLatin1Char(':') + QString::number(port);
+}
+
+void ProxyCache::compileNoProxy()
+{
+    trie.resize(1);
+    // KIO separates entries by commas and/or spaces
+    for(const QString &part : KProtocolManager::noProxyFor().split(QLatin1Char(',')))
+    {
+        for(const QString &entry : part.split(QLatin1Char(' ')))
+        {
+            if(entry.isEmpty())
+                continue;
+            QPair<QHostAddress, int> subnet = QHostAddress::parseSubnet(entry);
+            if(!subnet.first.isNull())
+                subnets << subnet;
+            else if(entry == QLatin1String("<local>"))
+                local = true;
+            else
+                addNoProxyEntry(entry.toLower());
+        }
+    }
+    compiled = true;
+}
+
+void ProxyCache::addNoProxyEntry(const QString& entry)
+{
+    // "http://host" only matches host itself, like KIO's revmatch
+    int start = entry.indexOf(QLatin1String("://"));
+    bool exact = start != -1;
+    start = exact ? start + 3 : 0;
+    if(start >= entry.size())
+        return;
+
+    int node = 0;
+    for(int i = entry.size() - 1; i >= start; --i)
+    {
+        int next = trie[node].children.value(entry[i], -1);
+        if(next == -1)
+        {
+            next = trie.size();
+            trie.append(TrieNode());
+            trie[node].children.insert(entry[i], next);
+        }
+        node = next;
+    }
+    if(exact)
+        trie[node].exact = true;
+    else
+        trie[node].suffix = true;
+}
+
+bool ProxyCache::matchesNoProxy(const QString& host) const
+{
+    int node = 0;
+    for(int i = host.size() - 1; i >= 0; --i)
+    {
+        node = trie[node].children.value(host[i], -1);
+        if(node == -1)
+            return false;
+        if(trie[node].suffix || (i == 0 && trie[node].exact))
+            return true;
+    }
+    return false;
+}
+
+bool ProxyCache::ignoreProxyFor(const QUrl& url)
+{
+    QString host = url.host().toLower();
+    bool match = false;
+    if(!host.isEmpty())
+    {
+        match = matchesNoProxy(host);
+        if(!match && url.port() > 0)
+            match = matchesNoProxy(host + QLatin1Char(':') + QString::number(url.port()));
+        if(!match && local && !host.contains(QLatin1Char('.')))
+            match = true;
+    }
+
+    QHostAddress address(host);
+    for(int i = 0; !match && !address.isNull() && i < subnets.size(); ++i)
+        match = address.isInSubnet(subnets.at(i));
+
+    // With a reverse list, the proxy is only used for the listed hosts
+    return KProtocolManager::useReverseProxy() != match;
+}
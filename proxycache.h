@@ -0,0 +1,80 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef PROXYCACHE_H
+#define PROXYCACHE_H
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QPair>
+#include <QtCore/QUrl>
+#include <QtCore/QVector>
+#include <QtNetwork/QHostAddress>
+
+#include <KCoreAddons/KDirWatch>
+
+#include "pacengine.h"
+#include "stats.h"
+
+/* Resolves proxies for URLs the way KIO does, but remembers the result per
+ * destination and matches the no-proxy list with a trie of reversed entries
+ * instead of evaluating the KIO configuration each time. Local PAC scripts
+ * are evaluated by PacEngine. Everything is recomputed when kioslaverc changes. */
+class ProxyCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProxyCache(QObject *parent = nullptr);
+    // The proxies for url in the format of PAC results, e.g. "PROXY host:port" or "DIRECT"
+    QString proxyFor(const QUrl& url);
+    const CacheStats *cacheStats() const { return &stats; }
+    const CacheStats *pacStats() const { return pac.cacheStats(); }
+signals:
+    // The proxy configuration changed, earlier answers may be wrong now
+    void changed();
+private slots:
+    void configChanged();
+private:
+    struct TrieNode
+    {
+        QHash<QChar, int> children;
+        bool suffix = false; // an entry ends here, matches any host ending with it
+        bool exact = false; // an URL entry ends here, matches only the whole host
+    };
+    QString resolve(const QUrl& url);
+    void compileNoProxy();
+    void addNoProxyEntry(const QString& entry);
+    bool matchesNoProxy(const QString& host) const;
+    bool ignoreProxyFor(const QUrl& url);
+    static QString toPacResult(const QString& proxy);
+    QHash<QString, QString> results;
+    QVector<TrieNode> trie; // the root is at index 0
+    QList<QPair<QHostAddress, int> > subnets;
+    bool local; // "<local>" is in the list
+    bool compiled;
+    PacEngine pac;
+    KDirWatch watch;
+    CacheStats stats;
+};
+
+#endif
@@ -0,0 +1,151 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "spawner.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <vector>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+
+extern char **environ;
+
+// in ms, how often to look for children that exited
+static const int REAP_INTERVAL = 5000;
+
+// Returns the pid, or -1 with errno set
+static pid_t spawnArgv(char *const argv[], char *const envp[], const char *workdir)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 29)
+    posix_spawn_file_actions_addchdir_np(&actions, workdir);
+    int cwd = -1;
+#else
+    // Only the main thread starts programs
+    int cwd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(chdir(workdir) != 0)
+        std::cerr << "Cannot change to " << workdir << std::endl;
+#endif
+
+    // The daemon ignores SIGPIPE, which would be inherited
+    sigset_t defaults, mask;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    sigemptyset(&mask);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+#ifdef POSIX_SPAWN_SETSID
+    // Like a detached start, not part of our session
+    flags |= POSIX_SPAWN_SETSID;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    // glibc reports exec failures here, it waits until the child did exec
+    pid_t pid;
+    int ret = posix_spawn(&pid, argv[0], &actions, &attr, argv, envp);
+
+    if(cwd >= 0)
+    {
+        if(fchdir(cwd) != 0)
+            std::cerr << "Cannot change back to the working directory" << std::endl;
+        close(cwd);
+    }
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if(ret != 0)
+    {
+        errno = ret;
+        return -1;
+    }
+    return pid;
+}
+
+Spawner::Spawner(QObject *parent)
+    : QObject(parent)
+{
+    reap_timer.setInterval(REAP_INTERVAL);
+    connect(&reap_timer, &QTimer::timeout, this, &Spawner::reap);
+}
+
+bool Spawner::spawn(const QStringList& argv, const QString& workdir)
+{
+    if(argv.isEmpty())
+        return false;
+
+    QList<QByteArray> args;
+    std::vector<char*> argp;
+    for(const QString &arg : argv)
+        args.append(QFile::encodeName(arg));
+    for(QByteArray &arg : args)
+        argp.push_back(arg.data());
+    argp.push_back(nullptr);
+
+    std::vector<char*> envp;
+    for(char **var = environ; *var; ++var)
+    {
+        if(strncmp(*var, "KMOZILLAHELPER_", 15) != 0)
+            envp.push_back(*var);
+    }
+    envp.push_back(nullptr);
+
+    QByteArray dir = QFile::encodeName(workdir.isEmpty() ? QDir::homePath() : workdir);
+    pid_t pid = spawnArgv(argp.data(), envp.data(), dir.constData());
+    if(pid < 0)
+    {
+        std::cerr << "Cannot run " << args.first().constData() << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    children.append(pid);
+    reap_timer.start();
+    return true;
+}
+
+void Spawner::reap()
+{
+    for(auto it = children.begin(); it != children.end();)
+    {
+        pid_t ret = waitpid(*it, nullptr, WNOHANG);
+        if(ret == *it || (ret < 0 && errno == ECHILD))
+            it = children.erase(it);
+        else
+            ++it;
+    }
+    if(children.isEmpty())
+        reap_timer.stop();
+}
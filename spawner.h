@@ -0,0 +1,53 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef SPAWNER_H
+#define SPAWNER_H
+
+#include <sys/types.h>
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+
+/* Starts programs directly from an argument vector with posix_spawn, without
+ * a shell parsing a command line in between, so failing to execute them is
+ * noticed right away. Children get /dev/null as stdin and stdout (which may
+ * be the connection to the browser), the environment without the helper's
+ * own variables, and are reaped once they exit. */
+class Spawner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Spawner(QObject *parent = nullptr);
+    // argv[0] has to be a path, without workdir the program starts in the home dir
+    bool spawn(const QStringList& argv, const QString& workdir = QString());
+private slots:
+    void reap();
+private:
+    QList<pid_t> children;
+    QTimer reap_timer;
+};
+
+#endif
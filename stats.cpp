@@ -0,0 +1,125 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "stats.h"
+
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <iostream>
+
+static int signal_fds[2] = { -1, -1 };
+
+static void signalHandler(int)
+{
+    // Only async-signal-safe things here, the rest happens in the event loop
+    char c = 0;
+    ssize_t ret = ::write(signal_fds[0], &c, 1);
+    (void) ret;
+}
+
+Stats::Stats(QObject *parent)
+    : QObject(parent)
+    , notifier(nullptr)
+{
+}
+
+void Stats::record(const QString& command, bool status, qint64 nsecs)
+{
+    CommandStats &stats = commands[command];
+    if(stats.ok + stats.failed == 0)
+        stats.first_nsecs = nsecs;
+    if(status)
+        ++stats.ok;
+    else
+        ++stats.failed;
+
+    qint64 usecs = nsecs / 1000;
+    int bucket = 0;
+    while(usecs > 0 && bucket < BUCKETS - 1)
+    {
+        usecs >>= 1;
+        ++bucket;
+    }
+    ++stats.buckets[bucket];
+}
+
+void Stats::addCache(const QString& name, const CacheStats *cache)
+{
+    caches << qMakePair(name, cache);
+}
+
+QStringList Stats::report() const
+{
+    QStringList lines;
+    QStringList names = commands.keys();
+    names.sort();
+    for(const QString &name : names)
+    {
+        const CommandStats &stats = commands[name];
+        QString line = QStringLiteral("%1 calls=%2 ok=%3 failed=%4 first_us=%5 latency_us=")
+                .arg(name).arg(stats.ok + stats.failed).arg(stats.ok).arg(stats.failed)
+                .arg(stats.first_nsecs / 1000);
+        QStringList buckets;
+        for(int i = 0; i < BUCKETS; ++i)
+        {
+            if(stats.buckets[i])
+                buckets << QStringLiteral("<%1:%2").arg(quint64(1) << i).arg(stats.buckets[i]);
+        }
+        lines << line + buckets.join(QLatin1Char(','));
+    }
+    for(const auto &cache : caches)
+    {
+        quint64 total = cache.second->hits + cache.second->misses;
+        lines << QStringLiteral("cache %1 hits=%2 misses=%3 ratio=%4")
+                 .arg(cache.first).arg(cache.second->hits).arg(cache.second->misses)
+                 .arg(total ? double(cache.second->hits) / total : 0.0, 0, 'f', 3);
+    }
+    return lines;
+}
+
+void Stats::installSignalHandler()
+{
+    if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, signal_fds) != 0)
+        return;
+    notifier = new QSocketNotifier(signal_fds[1], QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &Stats::dump);
+
+    struct sigaction action = {};
+    action.sa_handler = signalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+}
+
+void Stats::dump()
+{
+    char buf[64];
+    while(::read(signal_fds[1], buf, sizeof(buf)) > 0)
+        ;
+    std::cerr << "KDE helper statistics:\n";
+    for(const QString &line : report())
+        std::cerr << "  " << line.toStdString() << '\n';
+    std::cerr.flush();
+}
@@ -0,0 +1,70 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QPair>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QStringList>
+
+// Hit counters, each cache has one
+struct CacheStats
+{
+    quint64 hits = 0;
+    quint64 misses = 0;
+};
+
+/* Always-on statistics about handled commands: counts, success/failure and
+ * latency histograms with power of two buckets, plus hit ratios of the caches.
+ * Readable with the STATS command and dumped to stderr on SIGUSR1. */
+class Stats : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Stats(QObject *parent = nullptr);
+    void record(const QString& command, bool status, qint64 nsecs);
+    void addCache(const QString& name, const CacheStats *cache);
+    QStringList report() const;
+    // Dumps the report to stderr on SIGUSR1
+    void installSignalHandler();
+private slots:
+    void dump();
+private:
+    static const int BUCKETS = 32; // up to ~35 minutes
+    struct CommandStats
+    {
+        quint64 ok = 0;
+        quint64 failed = 0;
+        quint64 buckets[BUCKETS] = {}; // bucket i counts latencies below 2^i us
+        qint64 first_nsecs = 0; // of the first call, shows what prewarming saved
+    };
+    QHash<QString, CommandStats> commands;
+    QList<QPair<QString, const CacheStats*> > caches;
+    QSocketNotifier *notifier;
+};
+
+#endif
@@ -0,0 +1,190 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+/* Decodes trace files written by kmozillahelper --trace (or with
+ * KMOZILLAHELPER_TRACE set), oldest record first.
+ *
+ * By default every command and reply is printed with its time relative to the
+ * start of the trace and the latency of each reply. With --script only the
+ * commands are printed, in the script format of kmozillahelper-bench, so
+ * recorded sessions can be replayed. */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../tracefile.h"
+
+static std::string printable(const std::string& field)
+{
+    std::string ret;
+    for(char c : field)
+    {
+        if(c == '\n')
+            ret += "\\n";
+        else if(c == '\t')
+            ret += "\\t";
+        else
+            ret += c;
+    }
+    return ret;
+}
+
+static bool readFields(const char *data, const TraceRecord& rec, std::vector<std::string>& fields)
+{
+    size_t pos = sizeof(TraceRecord);
+    for(uint32_t i = 0; i < rec.fields; ++i)
+    {
+        uint32_t len;
+        if(pos + sizeof(len) > rec.size)
+            return false;
+        memcpy(&len, data + pos, sizeof(len));
+        pos += sizeof(len);
+        if(pos + len > rec.size)
+            return false;
+        fields.emplace_back(data + pos, len);
+        pos += len;
+    }
+    return fields.size() >= 2;
+}
+
+static void printScript(const std::vector<std::string>& fields)
+{
+    std::string line = fields[1];
+    for(size_t i = 2; i < fields.size(); ++i)
+    {
+        if(fields[i].find_first_of("\t\n") != std::string::npos)
+        {
+            std::cout << "# skipped " << printable(fields[1]) << ", arguments contain tabs or newlines" << std::endl;
+            return;
+        }
+        line += '\t' + fields[i];
+    }
+    std::cout << line << std::endl;
+}
+
+static void printRecord(const TraceHeader& header, const TraceRecord& rec, const std::vector<std::string>& fields,
+                        std::map<std::pair<uint32_t, std::string>, uint64_t>& pending)
+{
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%12.6f [%u] %s ", (rec.timestamp - header.monotonic_base) / 1e9,
+             rec.client, rec.type == TraceCommand ? ">" : "<");
+    std::cout << prefix;
+    if(!fields[0].empty())
+        std::cout << '#' << fields[0] << ' ';
+    std::cout << fields[1];
+
+    auto key = std::make_pair(rec.client, fields[0]);
+    if(rec.type == TraceCommand)
+        pending[key] = rec.timestamp;
+    else
+    {
+        std::cout << (rec.status ? " ok" : " failed");
+        auto it = pending.find(key);
+        if(it != pending.end())
+        {
+            snprintf(prefix, sizeof(prefix), " %.3fms", (rec.timestamp - it->second) / 1e6);
+            std::cout << prefix;
+            pending.erase(it);
+        }
+    }
+    for(size_t i = 2; i < fields.size(); ++i)
+        std::cout << (i == 2 ? " " : " | ") << printable(fields[i]);
+    std::cout << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    bool script = false, usage = false;
+    const char *path = nullptr;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--script") == 0)
+            script = true;
+        else if(!path && argv[i][0] != '-')
+            path = argv[i];
+        else
+            usage = true;
+    }
+    if(!path || usage)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--script] <tracefile>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::string file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    TraceHeader header;
+    if(!in || file.size() < sizeof(header))
+    {
+        std::cerr << "Cannot read " << path << std::endl;
+        return 1;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+    if(memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.version != TRACE_VERSION
+       || header.header_size + header.capacity != file.size() || header.tail >= header.capacity
+       || header.used > header.capacity)
+    {
+        std::cerr << path << " is not a kmozillahelper trace" << std::endl;
+        return 1;
+    }
+
+    const char *ring = file.data() + header.header_size;
+    std::map<std::pair<uint32_t, std::string>, uint64_t> pending;
+    uint64_t pos = header.tail;
+    for(uint64_t done = 0; done < header.used;)
+    {
+        TraceRecord rec = {};
+        memcpy(&rec, ring + pos, std::min<uint64_t>(sizeof(rec), header.capacity - pos));
+        if(rec.size < 8 || rec.size % 8 != 0 || pos + rec.size > header.capacity)
+        {
+            std::cerr << "Corrupt record at offset " << pos << std::endl;
+            return 1;
+        }
+        std::vector<std::string> fields;
+        if(rec.type != TracePadding)
+        {
+            if(!readFields(ring + pos, rec, fields))
+            {
+                std::cerr << "Corrupt record at offset " << pos << std::endl;
+                return 1;
+            }
+            if(!script)
+                printRecord(header, rec, fields, pending);
+            else if(rec.type == TraceCommand)
+                printScript(fields);
+        }
+        done += rec.size;
+        pos += rec.size;
+        if(pos == header.capacity)
+            pos = 0;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "trace.h"
+
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <iostream>
+
+#include <QtCore/QFile>
+
+// Longer fields are cut, e.g. huge file lists aren't interesting for traces
+static const int MAX_FIELD_SIZE = 64 * 1024;
+
+static quint64 now(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return quint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static quint64 align(quint64 size)
+{
+    return (size + 7) & ~quint64(7);
+}
+
+TraceRecorder::TraceRecorder()
+    : header(nullptr)
+    , ring(nullptr)
+    , mapped_size(0)
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    if(header)
+        munmap(header, mapped_size);
+}
+
+bool TraceRecorder::open(const QString& path, quint64 capacity)
+{
+    capacity = align(capacity);
+    mapped_size = sizeof(TraceHeader) + capacity;
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if(fd < 0 || ftruncate(fd, mapped_size) != 0)
+    {
+        std::cerr << "Cannot create trace file " << path.toStdString() << std::endl;
+        if(fd >= 0)
+            close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        std::cerr << "Cannot map trace file " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    header = static_cast<TraceHeader*>(map);
+    ring = static_cast<char*>(map) + sizeof(TraceHeader);
+    memcpy(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header->version = TRACE_VERSION;
+    header->header_size = sizeof(TraceHeader);
+    header->capacity = capacity;
+    header->head = header->tail = header->used = 0;
+    header->monotonic_base = now(CLOCK_MONOTONIC);
+    header->realtime_base = now(CLOCK_REALTIME);
+    return true;
+}
+
+void TraceRecorder::record(TraceRecordType type, quint32 client, bool status, const QString& tag,
+                           const QString& command, const QStringList& fields)
+{
+    if(!header)
+        return;
+
+    buf.resize(sizeof(TraceRecord));
+    auto appendField = [this](const QString& field)
+    {
+        QByteArray data = field.toUtf8().left(MAX_FIELD_SIZE);
+        quint32 len = data.size();
+        buf.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        buf.append(data);
+    };
+    appendField(tag);
+    appendField(command);
+    for(const QString &field : fields)
+        appendField(field);
+
+    TraceRecord *rec = reinterpret_cast<TraceRecord*>(buf.data());
+    rec->size = align(buf.size());
+    rec->type = type;
+    rec->status = status ? 1 : 0;
+    rec->client = client;
+    rec->fields = 2 + fields.size();
+    rec->timestamp = now(CLOCK_MONOTONIC);
+    // Zeroed, not whatever was on the heap, the file gets attached to bug reports
+    buf.append(QByteArray(int(rec->size) - buf.size(), '\0'));
+
+    // Would take over most of the ring
+    if(quint64(buf.size()) > header->capacity / 4)
+        return;
+    append(buf.constData(), buf.size());
+}
+
+void TraceRecorder::makeRoom(quint64 size)
+{
+    // Drop the oldest records
+    while(header->capacity - header->used < size)
+    {
+        quint32 oldest;
+        memcpy(&oldest, ring + header->tail, sizeof(oldest));
+        header->tail += oldest;
+        if(header->tail == header->capacity)
+            header->tail = 0;
+        header->used -= oldest;
+    }
+}
+
+void TraceRecorder::append(const char *data, quint64 size)
+{
+    if(header->head + size > header->capacity)
+    {
+        // Records don't wrap, fill the rest with padding
+        quint32 pad = header->capacity - header->head;
+        makeRoom(pad);
+        TraceRecord padding = {};
+        padding.size = pad;
+        padding.type = TracePadding;
+        memcpy(ring + header->head, &padding, qMin<quint64>(pad, sizeof(padding)));
+        header->used += pad;
+        header->head = 0;
+    }
+    makeRoom(size);
+    memcpy(ring + header->head, data, size);
+    header->head += size;
+    if(header->head == header->capacity)
+        header->head = 0;
+    header->used += size;
+}
@@ -0,0 +1,54 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QStringList>
+
+#include "tracefile.h"
+
+/* Records the command stream into a memory-mapped ring buffer file with
+ * compact binary records (see tracefile.h). Writing a record is only a copy
+ * into the mapping, so this is cheap enough to leave enabled. The oldest
+ * records get overwritten once the file is full. */
+class TraceRecorder
+{
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+    bool open(const QString& path, quint64 capacity);
+    bool isEnabled() const { return header != nullptr; }
+    void record(TraceRecordType type, quint32 client, bool status, const QString& tag,
+                const QString& command, const QStringList& fields);
+private:
+    void append(const char *data, quint64 size);
+    void makeRoom(quint64 size);
+    TraceHeader *header;
+    char *ring;
+    size_t mapped_size;
+    QByteArray buf;
+};
+
+#endif
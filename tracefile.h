@@ -0,0 +1,67 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include <cstdint>
+
+/* Layout of the trace files written by TraceRecorder and read by
+ * kmozillahelper-tracedump. The file is a header followed by a ring buffer
+ * of records, all numbers are in native byte order. */
+
+static const char TRACE_MAGIC[8] = { 'K', 'M', 'H', 'T', 'R', 'A', 'C', 'E' };
+static const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity; // size of the ring following the header
+    uint64_t head; // ring offset of the next record
+    uint64_t tail; // ring offset of the oldest record
+    uint64_t used; // bytes from tail to head
+    uint64_t monotonic_base; // CLOCK_MONOTONIC and CLOCK_REALTIME in ns
+    uint64_t realtime_base; // when the trace was started
+};
+
+enum TraceRecordType : uint16_t
+{
+    TracePadding = 0, // fills the end of the ring, skip it
+    TraceCommand = 1, // fields: request ID, command, arguments
+    TraceReply = 2 // fields: request ID, command, reply lines
+};
+
+// Records never wrap around the end of the ring and are 8 byte aligned
+struct TraceRecord
+{
+    uint32_t size; // including this header and the padding
+    uint16_t type;
+    uint16_t status; // for replies, 1 (ok) or 0 (failed)
+    uint32_t client; // always 1 unless in shared mode
+    uint32_t fields; // each a uint32_t length followed by UTF-8 data
+    uint64_t timestamp; // CLOCK_MONOTONIC in ns
+};
+
+#endif
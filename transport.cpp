@@ -0,0 +1,366 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "transport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <iostream>
+
+#include <QtCore/QtEndian>
+
+static const int READ_CHUNK = 64 * 1024;
+static const int MAX_IOVECS = 64;
+// Sanity limits for binary frames, anything bigger is garbage
+static const quint32 MAX_FIELDS = 64 * 1024;
+static const quint32 MAX_FIELD_SIZE = 16 * 1024 * 1024;
+
+static void setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+    if(flags != -1)
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+Transport::Transport(int infd, int outfd, QObject *parent)
+    : QObject(parent)
+    , framing(TextFraming)
+    , infd(infd)
+    , outfd(outfd)
+    , read_notifier(infd, QSocketNotifier::Read)
+    , write_notifier(outfd, QSocketNotifier::Write)
+    , inpos(0)
+    , scanpos(0)
+    , outpos(0)
+    , dispatching(false)
+    , eof(false)
+    , close_on_delete(false)
+{
+    setNonBlocking(infd);
+    setNonBlocking(outfd);
+    write_notifier.setEnabled(false);
+    connect(&read_notifier, &QSocketNotifier::activated,
+            this, &Transport::readData);
+    connect(&write_notifier, &QSocketNotifier::activated,
+            this, &Transport::flush);
+}
+
+Transport::~Transport()
+{
+    if(!close_on_delete)
+        return;
+    read_notifier.setEnabled(false);
+    write_notifier.setEnabled(false);
+    ::close(infd);
+    if(outfd != infd)
+        ::close(outfd);
+}
+
+void Transport::setCloseOnDelete(bool close)
+{
+    close_on_delete = close;
+}
+
+void Transport::readData()
+{
+    for(;;)
+    {
+        int size = inbuf.size();
+        inbuf.resize(size + READ_CHUNK);
+        ssize_t ret = ::read(infd, inbuf.data() + size, READ_CHUNK);
+        inbuf.resize(size + qMax(ret, ssize_t(0)));
+        if(ret == READ_CHUNK || (ret < 0 && errno == EINTR))
+            continue; // there might be more
+        if(ret == 0 || (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            eof = true;
+            read_notifier.setEnabled(false);
+        }
+        break;
+    }
+
+    // Replies to everything handled right now go out together
+    dispatching = true;
+    emit readyRead();
+    dispatching = false;
+
+    inbuf.remove(0, inpos);
+    scanpos -= inpos;
+    inpos = 0;
+
+    flush();
+
+    if(eof)
+        emit closed();
+}
+
+bool Transport::readFrame(QStringList &frame)
+{
+    if(framing == BinaryFraming)
+        return readBinaryFrame(frame);
+    return readTextFrame(frame);
+}
+
+void Transport::setFraming(Framing framing)
+{
+    this->framing = framing;
+    scanpos = inpos;
+}
+
+bool Transport::readTextFrame(QStringList &frame)
+{
+    // Find the "\E" line terminating the frame
+    for(;;)
+    {
+        int nl = inbuf.indexOf('\n', scanpos);
+        if(nl < 0)
+            return false;
+        const char *line = inbuf.constData() + scanpos;
+        bool end = nl - scanpos == 2 && line[0] == '\\' && line[1] == 'E';
+        scanpos = nl + 1;
+        if(end)
+            break;
+    }
+
+    frame.clear();
+    int end = scanpos - 3; // start of the "\E" line
+    for(int pos = inpos; pos < end;)
+    {
+        int nl = inbuf.indexOf('\n', pos);
+        frame.append(unescape(inbuf.constData() + pos, nl - pos));
+        pos = nl + 1;
+    }
+    inpos = scanpos;
+    return true;
+}
+
+bool Transport::readBinaryFrame(QStringList &frame)
+{
+    const uchar *data = reinterpret_cast<const uchar*>(inbuf.constData()) + inpos;
+    const quint32 avail = inbuf.size() - inpos;
+    if(avail < 4)
+        return false;
+    const quint32 count = qFromBigEndian<quint32>(data);
+    if(count == 0 || count > MAX_FIELDS)
+    {
+        protocolError("Invalid field count");
+        return false;
+    }
+
+    // Make sure the whole frame is there before decoding anything
+    quint32 pos = 4;
+    for(quint32 i = 0; i < count; ++i)
+    {
+        if(avail - pos < 4)
+            return false;
+        const quint32 len = qFromBigEndian<quint32>(data + pos);
+        if(len > MAX_FIELD_SIZE)
+        {
+            protocolError("Field too long");
+            return false;
+        }
+        if(avail - pos - 4 < len)
+            return false;
+        pos += 4 + len;
+    }
+
+    // Decode straight from the buffer, there is nothing to unescape
+    frame.clear();
+    frame.reserve(count);
+    pos = 4;
+    for(quint32 i = 0; i < count; ++i)
+    {
+        const quint32 len = qFromBigEndian<quint32>(data + pos);
+        frame.append(QString::fromUtf8(reinterpret_cast<const char*>(data) + pos + 4, len));
+        pos += 4 + len;
+    }
+    inpos += pos;
+    scanpos = inpos;
+    return true;
+}
+
+void Transport::protocolError(const char *message)
+{
+    // There is no way to find the next frame, so give up
+    std::cerr << "Protocol error in KDE helper: " << message << std::endl;
+    inbuf.clear();
+    inpos = scanpos = 0;
+    eof = true;
+    read_notifier.setEnabled(false);
+}
+
+QString Transport::unescape(const char *data, int len)
+{
+    if(!memchr(data, '\\', len))
+        return QString::fromUtf8(data, len);
+
+    // Single pass, so that e.g. "\\n" correctly turns into "\n" and not a newline
+    QByteArray raw;
+    raw.reserve(len);
+    for(int i = 0; i < len; ++i)
+    {
+        if(data[i] == '\\' && i + 1 < len)
+        {
+            ++i;
+            raw += data[i] == 'n' ? '\n' : data[i];
+        }
+        else
+            raw += data[i];
+    }
+    return QString::fromUtf8(raw);
+}
+
+void Transport::appendEscaped(QByteArray &out, const QString& line)
+{
+    QByteArray utf8 = line.toUtf8();
+    if(!utf8.contains('\\') && !utf8.contains('\n'))
+    {
+        out += utf8;
+        return;
+    }
+
+    out.reserve(out.size() + utf8.size() * 2);
+    for(char c : utf8)
+    {
+        if(c == '\\')
+            out += "\\\\";
+        else if(c == '\n')
+            out += "\\n";
+        else
+            out += c;
+    }
+}
+
+void Transport::appendField(QByteArray &out, const QByteArray& field)
+{
+    uchar len[4];
+    qToBigEndian<quint32>(field.size(), len);
+    out.append(reinterpret_cast<const char*>(len), 4);
+    out += field;
+}
+
+void Transport::writeReply(const QString& tag, const QStringList& lines, bool status)
+{
+    QByteArray out;
+    if(framing == BinaryFraming)
+    {
+        // Field count, tag (possibly empty), status byte, then the lines unescaped
+        uchar count[4];
+        qToBigEndian<quint32>(2 + lines.size(), count);
+        out.append(reinterpret_cast<const char*>(count), 4);
+        appendField(out, tag.toUtf8());
+        appendField(out, QByteArray(1, status ? '\1' : '\0'));
+        for(const QString &line : lines)
+            appendField(out, line.toUtf8());
+    }
+    else
+    {
+        if(!tag.isEmpty())
+        {
+            out += "\\R";
+            out += tag.toUtf8();
+            out += '\n';
+        }
+        for(const QString &line : lines)
+        {
+            appendEscaped(out, line);
+            out += '\n';
+        }
+        // status done as \1 (==ok) and \0 (==not ok), because otherwise this cannot happen
+        // in normal data (\ is escaped otherwise)
+        out += status ? "\\1\n" : "\\0\n";
+    }
+
+    outqueue.append(out);
+    if(!dispatching)
+        flush();
+}
+
+void Transport::writeEvent(const QString& event)
+{
+    QByteArray out;
+    if(framing == BinaryFraming)
+    {
+        // A single field, replies always have at least two
+        uchar count[4];
+        qToBigEndian<quint32>(1, count);
+        out.append(reinterpret_cast<const char*>(count), 4);
+        appendField(out, "EVENT " + event.toUtf8());
+    }
+    else
+    {
+        // Can't be mistaken for a reply line, those have backslashes escaped
+        out += "\\EVENT ";
+        appendEscaped(out, event);
+        out += '\n';
+    }
+
+    outqueue.append(out);
+    if(!dispatching)
+        flush();
+}
+
+void Transport::flush()
+{
+    while(!outqueue.isEmpty())
+    {
+        iovec iov[MAX_IOVECS];
+        int count = 0;
+        for(; count < MAX_IOVECS && count < outqueue.size(); ++count)
+        {
+            const QByteArray &buf = outqueue.at(count);
+            int skip = count == 0 ? outpos : 0;
+            iov[count].iov_base = const_cast<char*>(buf.constData()) + skip;
+            iov[count].iov_len = buf.size() - skip;
+        }
+
+        ssize_t ret = ::writev(outfd, iov, count);
+        if(ret < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // Continue once the other side read something
+                write_notifier.setEnabled(true);
+                return;
+            }
+            std::cerr << "Failed to write reply: " << strerror(errno) << std::endl;
+            outqueue.clear();
+            outpos = 0;
+            break;
+        }
+
+        outpos += ret;
+        while(!outqueue.isEmpty() && outpos >= outqueue.first().size())
+        {
+            outpos -= outqueue.first().size();
+            outqueue.removeFirst();
+        }
+    }
+    write_notifier.setEnabled(false);
+}
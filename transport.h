@@ -0,0 +1,87 @@
+/*****************************************************************
+
+Copyright (C) 2026 kmozillahelper contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QStringList>
+
+/* Reads commands from and writes replies to a pair of file descriptors
+ * (usually stdin/stdout) without blocking. Everything that is available is
+ * read on each wakeup, so no data can get stuck in a userspace buffer,
+ * and complete frames are handed out one by one. Replies are queued as one
+ * buffer each and written with as few writev calls as possible. */
+class Transport : public QObject
+{
+    Q_OBJECT
+public:
+    enum Framing
+    {
+        TextFraming, // escaped lines, frames terminated by "\E"
+        BinaryFraming // length-prefixed UTF-8 fields, see main.cpp
+    };
+    Transport(int infd, int outfd, QObject *parent = nullptr);
+    ~Transport();
+    // Whether the fds get closed with the transport, off by default
+    void setCloseOnDelete(bool close);
+    // Takes the next complete frame (command line and arguments) out of the buffer.
+    bool readFrame(QStringList &frame);
+    void writeReply(const QString& tag, const QStringList& lines, bool status);
+    // Unsolicited, only written between replies
+    void writeEvent(const QString& event);
+    void setFraming(Framing framing);
+signals:
+    // Emitted when new data arrived, call readFrame until it returns false
+    void readyRead();
+    // Emitted when the other side closed the connection and all frames were read
+    void closed();
+private slots:
+    void readData();
+    void flush();
+private:
+    bool readTextFrame(QStringList &frame);
+    bool readBinaryFrame(QStringList &frame);
+    void protocolError(const char *message);
+    static QString unescape(const char *data, int len);
+    static void appendEscaped(QByteArray &out, const QString& line);
+    static void appendField(QByteArray &out, const QByteArray& field);
+    Framing framing;
+    int infd;
+    int outfd;
+    QSocketNotifier read_notifier;
+    QSocketNotifier write_notifier;
+    QByteArray inbuf;
+    int inpos; // start of the first unread frame
+    int scanpos; // where to continue looking for the frame end
+    QList<QByteArray> outqueue;
+    int outpos; // already written bytes of outqueue.first()
+    bool dispatching;
+    bool eof;
+    bool close_on_delete;
+};
+
+#endif